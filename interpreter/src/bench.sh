@@ -0,0 +1,28 @@
+#!/bin/bash
+# Benchmark of the Java interpreter
+# Compiles the sources, then runs the scanner benchmark on generated code and
+# the expression benchmark on generated expressions
+#
+# Environment:
+#   MEGABYTES    size of the generated source for the scanner (default: 16)
+#   EXPRESSIONS  number of generated expressions (default: 10000)
+#   JAVA_OPTS    options of the JVM (default: none)
+
+set -e
+
+MEGABYTES=${MEGABYTES:-16}
+EXPRESSIONS=${EXPRESSIONS:-10000}
+
+cd "$(dirname "$0")"
+
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+javac -d "$out" main/jlox/*.java
+java -version 2>&1 | head -1
+
+echo "== scanner"
+java $JAVA_OPTS -cp "$out" main.jlox.ScannerBenchmark "$MEGABYTES"
+
+echo "== expressions"
+java $JAVA_OPTS -cp "$out" main.jlox.ExpressionBenchmark "$EXPRESSIONS"
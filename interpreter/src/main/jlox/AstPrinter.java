@@ -7,7 +7,7 @@ class AstPrinter implements Expr.Visitor<String> {
 
     @Override
     public String visitBinaryExpr(Expr.Binary expr) {
-        return parenthesize(expr.operator.lexeme, expr.left, expr.right);
+        return parenthesize(expr.operator.lexeme(), expr.left, expr.right);
     }
 
     @Override
@@ -23,7 +23,7 @@ class AstPrinter implements Expr.Visitor<String> {
 
     @Override
     public String visitUnaryExpr(Expr.Unary expr) {
-        return parenthesize(expr.operator.lexeme, expr.right);
+        return parenthesize(expr.operator.lexeme(), expr.right);
     }
 
     private String parenthesize(String name, Expr... exprs) {
@@ -43,9 +43,9 @@ class AstPrinter implements Expr.Visitor<String> {
         // Expression: (-123) * 45.67
         Expr expression = new Expr.Binary(
                 new Expr.Unary(
-                        new Token(TokenType.MINUS, "-", null, 1),
+                        new Token(TokenType.MINUS, "-", 1),
                         new Expr.Literal(123)),
-                new Token(TokenType.STAR, "*", null, 1),
+                new Token(TokenType.STAR, "*", 1),
                 new Expr.Grouping(new Expr.Literal(45.67)));
         System.out.println(new AstPrinter().print(expression));
     }
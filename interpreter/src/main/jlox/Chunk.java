@@ -0,0 +1,58 @@
+package main.jlox;
+
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.Map;
+
+// Compiled expression: the bytecode, the line of every byte for runtime errors,
+// and the constant pool. Numbers have a pool of their own, so they are never boxed.
+class Chunk {
+    static final int MAX_CONSTANTS = 65536;
+
+    byte[] code = new byte[16];
+    int[] lines = new int[16];
+    int count = 0;
+
+    double[] numbers = new double[8];
+    int numberCount = 0;
+    Object[] objects = new Object[8];
+    int objectCount = 0;
+
+    // The deepest the stack gets while the chunk runs.
+    int maxStack = 0;
+
+    // Equal constants share one slot of the pool. Numbers are told apart by their bits, so 0 and -0 stay different.
+    private final Map<Long, Integer> numberIndexes = new HashMap<>();
+    private final Map<Object, Integer> objectIndexes = new HashMap<>();
+
+    void write(byte value, int line) {
+        if (count == code.length) {
+            code = Arrays.copyOf(code, count * 2);
+            lines = Arrays.copyOf(lines, count * 2);
+        }
+
+        code[count] = value;
+        lines[count] = line;
+        count++;
+    }
+
+    int addNumber(double value) {
+        Integer index = numberIndexes.get(Double.doubleToRawLongBits(value));
+        if (index != null) return index;
+
+        if (numberCount == numbers.length) numbers = Arrays.copyOf(numbers, numberCount * 2);
+        numbers[numberCount] = value;
+        numberIndexes.put(Double.doubleToRawLongBits(value), numberCount);
+        return numberCount++;
+    }
+
+    int addObject(Object value) {
+        Integer index = objectIndexes.get(value);
+        if (index != null) return index;
+
+        if (objectCount == objects.length) objects = Arrays.copyOf(objects, objectCount * 2);
+        objects[objectCount] = value;
+        objectIndexes.put(value, objectCount);
+        return objectCount++;
+    }
+}
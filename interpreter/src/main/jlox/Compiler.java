@@ -0,0 +1,95 @@
+package main.jlox;
+
+// Lowers an expression tree to the bytecode of the VM, operands first, then the operator.
+class Compiler implements Expr.Visitor<Void> {
+    private Chunk chunk;
+    private int depth;
+    // Literals have no token, their instructions get the line of the last operator.
+    private int line;
+
+    Chunk compile(Expr expression) {
+        chunk = new Chunk();
+        depth = 0;
+        line = 1;
+
+        expression.accept(this);
+        emit(OpCode.RETURN);
+
+        return chunk;
+    }
+
+    @Override
+    public Void visitBinaryExpr(Expr.Binary expr) {
+        expr.left.accept(this);
+        expr.right.accept(this);
+
+        line = expr.operator.line;
+        switch (expr.operator.type) {
+            case BANG_EQUAL:    emit(OpCode.NOT_EQUAL); break;
+            case EQUAL_EQUAL:   emit(OpCode.EQUAL); break;
+            case GREATER:       emit(OpCode.GREATER); break;
+            case GREATER_EQUAL: emit(OpCode.GREATER_EQUAL); break;
+            case LESS:          emit(OpCode.LESS); break;
+            case LESS_EQUAL:    emit(OpCode.LESS_EQUAL); break;
+            case MINUS:         emit(OpCode.SUBTRACT); break;
+            case PLUS:          emit(OpCode.ADD); break;
+            case SLASH:         emit(OpCode.DIVIDE); break;
+            case STAR:          emit(OpCode.MULTIPLY); break;
+        }
+
+        // Two operands are replaced by the result.
+        depth--;
+        return null;
+    }
+
+    @Override
+    public Void visitGroupingExpr(Expr.Grouping expr) {
+        // Parentheses only change the order of the instructions.
+        return expr.expression.accept(this);
+    }
+
+    @Override
+    public Void visitLiteralExpr(Expr.Literal expr) {
+        if (expr.value == null) {
+            emit(OpCode.NIL);
+        } else if (expr.value instanceof Boolean) {
+            emit((boolean) expr.value ? OpCode.TRUE : OpCode.FALSE);
+        } else if (expr.value instanceof Double) {
+            emitConstant(OpCode.NUMBER, chunk.addNumber((double) expr.value));
+        } else {
+            emitConstant(OpCode.OBJECT, chunk.addObject(expr.value));
+        }
+
+        depth++;
+        if (depth > chunk.maxStack) chunk.maxStack = depth;
+        return null;
+    }
+
+    @Override
+    public Void visitUnaryExpr(Expr.Unary expr) {
+        expr.right.accept(this);
+
+        line = expr.operator.line;
+        switch (expr.operator.type) {
+            case BANG:  emit(OpCode.NOT); break;
+            case MINUS: emit(OpCode.NEGATE); break;
+        }
+
+        return null;
+    }
+
+    private void emit(byte op) {
+        chunk.write(op, line);
+    }
+
+    private void emitConstant(byte op, int index) {
+        if (index >= Chunk.MAX_CONSTANTS) {
+            Lox.error(line, "Too many constants in one expression.");
+            index = 0;
+        }
+
+        emit(op);
+        emit((byte) (index >> 8));
+        emit((byte) index);
+    }
+}
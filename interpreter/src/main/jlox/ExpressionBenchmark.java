@@ -0,0 +1,221 @@
+package main.jlox;
+
+import java.io.IOException;
+import java.lang.management.ManagementFactory;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+
+
+// Evaluation speed of the tree-walking Interpreter and the bytecode VM on the same expressions,
+// one expression per line, as parsed and after the Optimizer.
+// Every iteration evaluates all of them, the first ones warm up the JIT.
+// The language has only literals, so the Optimizer folds every correct expression into one literal and
+// the optimized runs measure loading a constant. They are not compared with the others as a speedup,
+// the time of optimizing is compared with the time it saves on every run instead. Optimizing is timed
+// in one pass without warm-up, as the compiler would run it.
+public class ExpressionBenchmark {
+    private static final int WARMUP_ITERATIONS = 10;
+    private static final int MEASURED_ITERATIONS = 20;
+    private static final int GENERATED_DEPTH = 6;
+
+    // Keeps the results alive, so the JIT can't drop the work.
+    static long sink;
+
+    public static void main(String[] args) throws IOException {
+        if (args.length > 1) {
+            System.out.println("Usage: expression_benchmark [expressions | script]");
+            System.exit(64);
+        }
+
+        List<String> lines;
+        if (args.length == 1 && !args[0].matches("[0-9]+")) {
+            lines = Files.readAllLines(Paths.get(args[0]));
+        } else {
+            lines = generate(args.length == 1 ? Integer.parseInt(args[0]) : 10000);
+        }
+
+        List<Expr> expressions = new ArrayList<>();
+        for (String line : lines) {
+            if (line.trim().isEmpty()) continue;
+            Expr expression = new Parser(new Scanner(line)).parse();
+            if (expression != null) expressions.add(expression);
+        }
+        if (Lox.hadError) System.exit(65);
+
+        long time = System.nanoTime();
+        List<Expr> optimized = new ArrayList<>();
+        Optimizer optimizer = new Optimizer();
+        for (Expr expression : expressions) {
+            optimized.add(optimizer.optimize(expression));
+        }
+        time = System.nanoTime() - time;
+        if (Lox.hadError) System.exit(65);
+
+        int folded = 0;
+        for (Expr expression : optimized) {
+            if (expression instanceof Expr.Literal) folded++;
+        }
+        double optimizing = (double) time / expressions.size();
+
+        System.out.printf("%d expressions, optimized in %.1f ms, %d folded into a single literal%n",
+                expressions.size(), time / 1e6, folded);
+        List<Chunk> chunks = compile("parsed", expressions);
+        List<Chunk> optimizedChunks = compile("optimized", optimized);
+
+        double walker = measure("tree-walker", expressions, chunks, false);
+        double vm = measure("vm", expressions, chunks, true);
+        double optimizedWalker = measure("tree-walker optimized", optimized, optimizedChunks, false);
+        double optimizedVm = measure("vm optimized", optimized, optimizedChunks, true);
+        System.out.printf("vm is %.1fx faster than the tree-walker%n", walker / vm);
+        System.out.printf("optimized runs evaluate %d of %d expressions as one literal, they measure loading a constant%n",
+                folded, expressions.size());
+        payoff("tree-walker", optimizing, walker - optimizedWalker);
+        payoff("vm", optimizing, vm - optimizedVm);
+    }
+
+    // Folding is done once, the evaluator saves time on every run of the expression.
+    private static void payoff(String name, double optimizing, double saved) {
+        if (saved <= 0) {
+            System.out.printf("%-11s optimizing costs %.1f ns/expression and saves nothing on a run%n", name, optimizing);
+            return;
+        }
+        System.out.printf("%-11s optimizing costs %.1f ns/expression once, saves %.1f ns on every run, pays off after %.1f runs%n",
+                name, optimizing, saved, optimizing / saved);
+    }
+
+    private static List<Chunk> compile(String name, List<Expr> expressions) {
+        long time = System.nanoTime();
+        List<Chunk> chunks = new ArrayList<>();
+        for (Expr expression : expressions) {
+            chunks.add(new Compiler().compile(expression));
+        }
+        time = System.nanoTime() - time;
+
+        long nodes = 0;
+        long bytes = 0;
+        for (int i = 0; i < expressions.size(); i++) {
+            nodes += countNodes(expressions.get(i));
+            bytes += chunks.get(i).count;
+        }
+
+        System.out.printf("%-10s %10d nodes %10d bytes of bytecode, compiled in %.1f ms%n",
+                name, nodes, bytes, time / 1e6);
+        return chunks;
+    }
+
+    // Returns nanoseconds per expression.
+    private static double measure(String name, List<Expr> expressions, List<Chunk> chunks, boolean bytecode) {
+        com.sun.management.ThreadMXBean threads =
+                (com.sun.management.ThreadMXBean) ManagementFactory.getThreadMXBean();
+        long thread = Thread.currentThread().getId();
+        Interpreter interpreter = new Interpreter();
+        VM vm = new VM();
+
+        for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+            evaluate(interpreter, vm, expressions, chunks, bytecode);
+        }
+
+        long allocated = threads.getThreadAllocatedBytes(thread);
+        long time = System.nanoTime();
+        for (int i = 0; i < MEASURED_ITERATIONS; i++) {
+            evaluate(interpreter, vm, expressions, chunks, bytecode);
+        }
+        time = System.nanoTime() - time;
+        allocated = threads.getThreadAllocatedBytes(thread) - allocated;
+
+        long evaluations = (long) expressions.size() * MEASURED_ITERATIONS;
+        double nanos = (double) time / evaluations;
+        System.out.printf("%-22s %,14.0f expressions/s %8.1f ns/expression %8.1f bytes allocated/expression%n",
+                name, evaluations / (time / 1e9), nanos, (double) allocated / evaluations);
+        return nanos;
+    }
+
+    private static void evaluate(Interpreter interpreter, VM vm, List<Expr> expressions, List<Chunk> chunks,
+                                 boolean bytecode) {
+        try {
+            for (int i = 0; i < expressions.size(); i++) {
+                Object value = bytecode ? vm.run(chunks.get(i)) : interpreter.evaluate(expressions.get(i));
+                sink += value == null ? 0 : value.hashCode();
+            }
+        } catch (RuntimeError error) {
+            Lox.runtimeError(error);
+            System.exit(70);
+        }
+    }
+
+    static long countNodes(Expr expression) {
+        return expression.accept(new Expr.Visitor<Long>() {
+            @Override
+            public Long visitBinaryExpr(Expr.Binary expr) {
+                return 1 + expr.left.accept(this) + expr.right.accept(this);
+            }
+
+            @Override
+            public Long visitGroupingExpr(Expr.Grouping expr) {
+                return 1 + expr.expression.accept(this);
+            }
+
+            @Override
+            public Long visitLiteralExpr(Expr.Literal expr) {
+                return 1L;
+            }
+
+            @Override
+            public Long visitUnaryExpr(Expr.Unary expr) {
+                return 1 + expr.right.accept(this);
+            }
+        });
+    }
+
+    // Expressions are generated by the type of their value, so they never fail at runtime.
+    static List<String> generate(int count) {
+        Random random = new Random(42);
+        List<String> lines = new ArrayList<>();
+
+        for (int i = 0; i < count; i++) {
+            lines.add(generateBoolean(random, GENERATED_DEPTH));
+        }
+
+        return lines;
+    }
+
+    private static String generateNumber(Random random, int depth) {
+        if (depth == 0) {
+            return random.nextBoolean() ? Integer.toString(random.nextInt(100)) : random.nextInt(100) + ".5";
+        }
+
+        String[] operators = { "+", "-", "*" };
+        switch (random.nextInt(6)) {
+            case 0: return "-" + generateNumber(random, depth - 1);
+            case 1: return "(" + generateNumber(random, depth - 1) + ")";
+            // Division by zero is an error, so the divisor is never zero.
+            case 2: return generateNumber(random, depth - 1) + " / " + (random.nextInt(99) + 1);
+            default:
+                return generateNumber(random, depth - 1) + " " + operators[random.nextInt(operators.length)] + " " +
+                        generateNumber(random, depth - 1);
+        }
+    }
+
+    private static String generateString(Random random, int depth) {
+        if (depth == 0 || random.nextBoolean()) return "\"s" + random.nextInt(10) + "\"";
+
+        return generateString(random, depth - 1) + " + " + generateString(random, depth - 1);
+    }
+
+    private static String generateBoolean(Random random, int depth) {
+        String[] comparisons = { "<", "<=", ">", ">=", "==", "!=" };
+        switch (depth == 0 ? 0 : random.nextInt(5)) {
+            case 0: return random.nextBoolean() ? "true" : "nil == nil";
+            case 1: return "!(" + generateBoolean(random, depth - 1) + ")";
+            case 2: return "(" + generateBoolean(random, depth - 1) + ") == (" +
+                    generateBoolean(random, depth - 1) + ")";
+            case 3: return generateString(random, depth - 1) + " != " + generateString(random, depth - 1);
+            default:
+                return generateNumber(random, depth - 1) + " " + comparisons[random.nextInt(comparisons.length)] +
+                        " " + generateNumber(random, depth - 1);
+        }
+    }
+}
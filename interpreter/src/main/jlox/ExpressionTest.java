@@ -0,0 +1,143 @@
+package main.jlox;
+
+import java.io.ByteArrayOutputStream;
+import java.io.PrintStream;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.function.Supplier;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+
+// The bytecode VM and the Optimizer must give what the tree-walking Interpreter gives for the parsed tree:
+// the same value of the same type, or the same error on the same line. An error the Optimizer finds
+// is reported at compile time, and it must be the one the program would fail with.
+// Checked on the expressions of ExpressionBenchmark and on ones that fail.
+// Prints every mismatch and exits with 1 if there are any.
+public class ExpressionTest {
+    private static final int GENERATED = 10000;
+
+    // First error reported by `Lox.error()`: "[line 1] Error at '/': Division by zero."
+    private static final Pattern COMPILE_ERROR = Pattern.compile("\\[line (\\d+)\\] Error(?: at '[^']*')?: (.*)");
+
+    private static final String[] EXPRESSIONS = {
+        "1 + 2 * 3",
+        "(1 + 2) * 3",
+        "10 / 4",
+        "1 / 3 * 3",
+        "- -3",
+        "-(-(3))",
+        "-0",
+        "0 * -1",
+        "\"a\" + \"b\"",
+        "\"a\" + \"b\" == \"ab\"",
+        "1 == 1.0",
+        "1 == \"1\"",
+        "nil == nil",
+        "nil == false",
+        "!nil",
+        "!!nil",
+        "!!!nil",
+        "!!true",
+        "!!(1 < 2)",
+        "!0",
+        "!\"\"",
+        "true != false",
+        "1 < 2 == 2 > 1",
+        "3 >= 3",
+        "2 <= 1",
+        // Errors.
+        "1 / 0",
+        "1 / (2 - 2)",
+        "\"a\" - 1",
+        "-\"a\"",
+        "- -\"a\"",
+        "- -(\"a\" + \"b\")",
+        "\"a\" + 1",
+        "1 + nil",
+        "true < false",
+        "1 < \"2\"",
+        "!(1 / 0)",
+        "!!(\"a\" - 1)",
+        "(1 / 0) + (\"a\" - 1)",
+    };
+
+    private static int failed = 0;
+
+    public static void main(String[] args) {
+        List<String> lines = new ArrayList<>(Arrays.asList(EXPRESSIONS));
+        lines.addAll(ExpressionBenchmark.generate(GENERATED));
+
+        Interpreter interpreter = new Interpreter();
+        Optimizer optimizer = new Optimizer();
+        VM vm = new VM();
+
+        for (String line : lines) {
+            Expr expression = new Parser(new Scanner(line)).parse();
+            if (expression == null) {
+                // The syntax error is already reported.
+                failed++;
+                continue;
+            }
+
+            String expected = outcome(() -> interpreter.evaluate(expression));
+            check(line, "vm", expected, outcome(() -> vm.run(new Compiler().compile(expression))));
+
+            // Errors of the Optimizer are reported to stderr, they are taken from there.
+            PrintStream err = System.err;
+            ByteArrayOutputStream reported = new ByteArrayOutputStream();
+            Expr optimized;
+            System.setErr(new PrintStream(reported, true));
+            try {
+                optimized = optimizer.optimize(expression);
+            } finally {
+                System.setErr(err);
+            }
+
+            if (Lox.hadError) {
+                Lox.hadError = false;
+                check(line, "optimizer", expected, compileError(reported.toString()));
+                continue;
+            }
+
+            check(line, "optimized tree-walker", expected, outcome(() -> interpreter.evaluate(optimized)));
+            check(line, "optimized vm", expected, outcome(() -> vm.run(new Compiler().compile(optimized))));
+
+            // Only literals are left in the language, so a correct expression folds completely.
+            if (!expected.startsWith("error") && !(optimized instanceof Expr.Literal)) {
+                check(line, "folding", "one literal", new AstPrinter().print(optimized));
+            }
+        }
+
+        System.out.printf("%d expressions, %d failed%n", lines.size(), failed);
+        if (failed > 0) System.exit(1);
+    }
+
+    private static void check(String line, String name, String expected, String actual) {
+        if (expected.equals(actual)) return;
+
+        System.out.println("FAIL: " + line);
+        System.out.println("  expected:  " + expected);
+        System.out.printf("  %-10s %s%n", name + ":", actual);
+        failed++;
+    }
+
+    // The type is a part of the value, so 1 and "1" differ, and so do 0 and -0.
+    static String outcome(Supplier<Object> evaluation) {
+        try {
+            Object value = evaluation.get();
+            if (value == null) return "nil";
+            return value.getClass().getSimpleName() + " " + Interpreter.stringify(value);
+        } catch (RuntimeError error) {
+            return "error on line " + error.line + ": " + error.getMessage();
+        }
+    }
+
+    // The first reported error in the form of `outcome()`.
+    private static String compileError(String reported) {
+        Matcher matcher = COMPILE_ERROR.matcher(reported.split("\\R", 2)[0]);
+        if (!matcher.matches()) return reported;
+        return "error on line " + matcher.group(1) + ": " + matcher.group(2);
+    }
+}
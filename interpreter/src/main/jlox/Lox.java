@@ -3,14 +3,14 @@ package main.jlox;
 import java.io.BufferedReader;
 import java.io.IOException;
 import java.io.InputStreamReader;
-import java.nio.charset.Charset;
 import java.nio.file.Files;
 import java.nio.file.Paths;
-import java.util.List;
 
 
 public class Lox {
+    private static final VM vm = new VM();
     static boolean hadError = false;
+    static boolean hadRuntimeError = false;
 
     public static void main(String[] args) throws IOException {
         if (args.length > 1) {
@@ -24,9 +24,13 @@ public class Lox {
     }
 
     private static void runFile(String path) throws IOException {
+        // The scanner reads the bytes of the file as they are, without decoding them into a String.
         byte[] bytes = Files.readAllBytes(Paths.get(path));
-        run(new String(bytes, Charset.defaultCharset()));
+        run(new Scanner(bytes));
+
+        // Indicate an error in the exit code.
         if (hadError) System.exit(65);
+        if (hadRuntimeError) System.exit(70);
     }
 
     private static void runPrompt() throws IOException {
@@ -37,25 +41,45 @@ public class Lox {
             System.out.print(">>> ");
             String line = reader.readLine();
             if (line == null) break;
-            run(line);
+            run(new Scanner(line));
             hadError = false;
         }
     }
 
-    private static void run(String source) {
-        Scanner scanner = new Scanner(source);
-        List<Token> tokens = scanner.scanTokens();
+    private static void run(Scanner scanner) {
+        Parser parser = new Parser(scanner);
+        Expr expression = parser.parse();
 
-        // For now, just print the tokens.
-        for (Token token : tokens) {
-            System.out.println(token);
-        }
+        // Stop if there was a syntax error.
+        if (hadError) return;
+
+        // Constant parts are evaluated once here, not on every run.
+        expression = new Optimizer().optimize(expression);
+        if (hadError) return;
+
+        Chunk chunk = new Compiler().compile(expression);
+        if (hadError) return;
+
+        vm.interpret(chunk);
     }
 
     static void error(int line, String message) {
         report(line, "", message);
     }
 
+    static void error(Token token, String message) {
+        if (token.type == TokenType.EOF) {
+            report(token.line, " at end", message);
+        } else {
+            report(token.line, " at '" + token.lexeme() + "'", message);
+        }
+    }
+
+    static void runtimeError(RuntimeError error) {
+        System.err.println(error.getMessage() + "\n[line " + error.line + "]");
+        hadRuntimeError = true;
+    }
+
     private static void report(int line, String where,
                                String message) {
         System.err.println(
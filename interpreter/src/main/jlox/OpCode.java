@@ -0,0 +1,32 @@
+package main.jlox;
+
+// Instructions of the VM, one byte each. NUMBER and OBJECT are followed by
+// a two-byte index into the constant pool of the chunk.
+final class OpCode {
+    // Constants.
+    static final byte NUMBER = 0;
+    static final byte OBJECT = 1;
+    static final byte NIL = 2;
+    static final byte TRUE = 3;
+    static final byte FALSE = 4;
+
+    // Arithmetic.
+    static final byte ADD = 5;
+    static final byte SUBTRACT = 6;
+    static final byte MULTIPLY = 7;
+    static final byte DIVIDE = 8;
+    static final byte NEGATE = 9;
+
+    // Logic and comparison.
+    static final byte NOT = 10;
+    static final byte EQUAL = 11;
+    static final byte NOT_EQUAL = 12;
+    static final byte GREATER = 13;
+    static final byte GREATER_EQUAL = 14;
+    static final byte LESS = 15;
+    static final byte LESS_EQUAL = 16;
+
+    static final byte RETURN = 17;
+
+    private OpCode() {}
+}
@@ -0,0 +1,108 @@
+package main.jlox;
+
+// Compile-time pass over the tree. Operators whose operands are literals are evaluated here once
+// instead of on every run, groupings are dropped and double negations are removed.
+// An operator that would fail on every run, e.g. a division by zero, is reported as a compile error.
+class Optimizer implements Expr.Visitor<Expr> {
+    // Folding uses the evaluator itself, so a folded value is always the one the program would get.
+    private final Interpreter interpreter = new Interpreter();
+
+    Expr optimize(Expr expr) {
+        return expr.accept(this);
+    }
+
+    @Override
+    public Expr visitBinaryExpr(Expr.Binary expr) {
+        Expr left = optimize(expr.left);
+        Expr right = optimize(expr.right);
+
+        if (left != expr.left || right != expr.right) {
+            expr = new Expr.Binary(left, expr.operator, right);
+        }
+
+        if (left instanceof Expr.Literal && right instanceof Expr.Literal) {
+            return fold(expr, expr.operator);
+        }
+
+        return expr;
+    }
+
+    @Override
+    public Expr visitGroupingExpr(Expr.Grouping expr) {
+        // The tree already has the order the parentheses gave.
+        return optimize(expr.expression);
+    }
+
+    @Override
+    public Expr visitLiteralExpr(Expr.Literal expr) {
+        return expr;
+    }
+
+    @Override
+    public Expr visitUnaryExpr(Expr.Unary expr) {
+        Expr right = optimize(expr.right);
+
+        if (right != expr.right) {
+            expr = new Expr.Unary(expr.operator, right);
+        }
+
+        if (right instanceof Expr.Literal) {
+            return fold(expr, expr.operator);
+        }
+
+        // The same operator twice gives back the operand, if the operand already has the type of the result.
+        if (right instanceof Expr.Unary && ((Expr.Unary) right).operator.type == expr.operator.type) {
+            Expr operand = ((Expr.Unary) right).right;
+            if (expr.operator.type == TokenType.MINUS && isNumber(operand)) return operand;
+            if (expr.operator.type == TokenType.BANG && isBoolean(operand)) return operand;
+        }
+
+        return expr;
+    }
+
+    private Expr fold(Expr expr, Token operator) {
+        try {
+            return new Expr.Literal(interpreter.evaluate(expr));
+        } catch (RuntimeError error) {
+            Lox.error(operator, error.getMessage());
+            return expr;
+        }
+    }
+
+    // The expression gives a number or fails.
+    private static boolean isNumber(Expr expr) {
+        if (expr instanceof Expr.Literal) return ((Expr.Literal) expr).value instanceof Double;
+        if (expr instanceof Expr.Unary) return ((Expr.Unary) expr).operator.type == TokenType.MINUS;
+        if (expr instanceof Expr.Binary) {
+            switch (((Expr.Binary) expr).operator.type) {
+                case MINUS:
+                case SLASH:
+                case STAR:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    // The expression gives a boolean or fails.
+    private static boolean isBoolean(Expr expr) {
+        if (expr instanceof Expr.Literal) return ((Expr.Literal) expr).value instanceof Boolean;
+        if (expr instanceof Expr.Unary) return ((Expr.Unary) expr).operator.type == TokenType.BANG;
+        if (expr instanceof Expr.Binary) {
+            switch (((Expr.Binary) expr).operator.type) {
+                case BANG_EQUAL:
+                case EQUAL_EQUAL:
+                case GREATER:
+                case GREATER_EQUAL:
+                case LESS:
+                case LESS_EQUAL:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+}
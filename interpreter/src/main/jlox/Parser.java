@@ -1,16 +1,29 @@
 package main.jlox;
 
-import java.util.List;
-
 import static main.jlox.TokenType.*;
 
 
 class Parser {
-    private final List<Token> tokens;
-    private int current = 0;
+    private static class ParseError extends RuntimeException {}
+
+    // Tokens are pulled from the scanner one at a time, only the current one and the previous one are kept.
+    private final Scanner scanner;
+    private Token current;
+    private Token previous;
+
+    Parser(Scanner scanner) {
+        this.scanner = scanner;
+        this.current = scanner.nextToken();
+    }
 
-    Parser(List<Token> tokens) {
-        this.tokens = tokens;
+    Expr parse() {
+        try {
+            Expr expr = expression();
+            if (!isAtEnd()) throw error(peek(), "Expect end of expression.");
+            return expr;
+        } catch (ParseError error) {
+            return null;
+        }
     }
 
     private Expr expression() {
@@ -29,6 +42,70 @@ class Parser {
         return expr;
     }
 
+    private Expr comparison() {
+        Expr expr = term();
+
+        while (match(GREATER, GREATER_EQUAL, LESS, LESS_EQUAL)) {
+            Token operator = previous();
+            Expr right = term();
+            expr = new Expr.Binary(expr, operator, right);
+        }
+
+        return expr;
+    }
+
+    private Expr term() {
+        Expr expr = factor();
+
+        while (match(MINUS, PLUS)) {
+            Token operator = previous();
+            Expr right = factor();
+            expr = new Expr.Binary(expr, operator, right);
+        }
+
+        return expr;
+    }
+
+    private Expr factor() {
+        Expr expr = unary();
+
+        while (match(SLASH, STAR)) {
+            Token operator = previous();
+            Expr right = unary();
+            expr = new Expr.Binary(expr, operator, right);
+        }
+
+        return expr;
+    }
+
+    private Expr unary() {
+        if (match(BANG, MINUS)) {
+            Token operator = previous();
+            Expr right = unary();
+            return new Expr.Unary(operator, right);
+        }
+
+        return primary();
+    }
+
+    private Expr primary() {
+        if (match(FALSE)) return new Expr.Literal(false);
+        if (match(TRUE)) return new Expr.Literal(true);
+        if (match(NIL)) return new Expr.Literal(null);
+
+        if (match(NUMBER, STRING)) {
+            return new Expr.Literal(previous().literal());
+        }
+
+        if (match(LEFT_PAREN)) {
+            Expr expr = expression();
+            consume(RIGHT_PAREN, "Expect ')' after expression.");
+            return new Expr.Grouping(expr);
+        }
+
+        throw error(peek(), "Expect expression.");
+    }
+
     private boolean match(TokenType... types) {
         for (TokenType type : types) {
             if (check(type)) {
@@ -39,13 +116,22 @@ class Parser {
         return false;
     }
 
+    private Token consume(TokenType type, String message) {
+        if (check(type)) return advance();
+
+        throw error(peek(), message);
+    }
+
     private boolean check(TokenType type) {
         if (isAtEnd()) return false;
         return peek().type == type;
     }
 
     private Token advance() {
-        if (!isAtEnd()) current++;
+        if (!isAtEnd()) {
+            previous = current;
+            current = scanner.nextToken();
+        }
         return previous();
     }
 
@@ -54,10 +140,15 @@ class Parser {
     }
 
     private Token peek() {
-        return tokens.get(current);
+        return current;
     }
 
     private Token previous() {
-        return tokens.get(current - 1);
+        return previous;
+    }
+
+    private ParseError error(Token token, String message) {
+        Lox.error(token, message);
+        return new ParseError();
     }
 }
@@ -0,0 +1,14 @@
+package main.jlox;
+
+class RuntimeError extends RuntimeException {
+    final int line;
+
+    RuntimeError(Token token, String message) {
+        this(token.line, message);
+    }
+
+    RuntimeError(int line, String message) {
+        super(message);
+        this.line = line;
+    }
+}
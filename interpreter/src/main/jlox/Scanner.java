@@ -1,121 +1,159 @@
 package main.jlox;
 
+import java.nio.charset.StandardCharsets;
 import java.util.ArrayList;
-import java.util.HashMap;
 import java.util.List;
-import java.util.Map;
 
 
 class Scanner {
-    private final String source;
-    private final List<Token> tokens = new ArrayList<>();
+    private final byte[] source;
     private int start = 0;
     private int current = 0;
     private int line = 1;
 
-    private static final Map<String, TokenType> keywords;
-
-    static {
-        keywords = new HashMap<>();
-        keywords.put("and",     TokenType.AND);
-        keywords.put("class",   TokenType.CLASS);
-        keywords.put("else",    TokenType.ELSE);
-        keywords.put("false",   TokenType.FALSE);
-        keywords.put("for",     TokenType.FOR);
-        keywords.put("fun",     TokenType.FUN);
-        keywords.put("if",      TokenType.IF);
-        keywords.put("nil",     TokenType.NIL);
-        keywords.put("or",      TokenType.OR);
-        keywords.put("print",   TokenType.PRINT);
-        keywords.put("return",  TokenType.RETURN);
-        keywords.put("super",   TokenType.SUPER);
-        keywords.put("this",    TokenType.THIS);
-        keywords.put("true",    TokenType.TRUE);
-        keywords.put("var",     TokenType.VAR);
-        keywords.put("while",   TokenType.WHILE);
+    // Every power of ten up to 1e22 is exact as a double.
+    private static final double[] POWERS_OF_TEN = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    Scanner(byte[] source) {
+        this.source = source;
     }
 
     Scanner(String source) {
-        this.source = source;
+        this(source.getBytes(StandardCharsets.UTF_8));
     }
 
-    List<Token> scanTokens() {
-        while (!isAtEnd()) {
+    Token nextToken() {
+        for (;;) {
             // We are at the beginning of the next lexeme.
             start = current;
-            scanToken();
+            if (isAtEnd()) return makeToken(TokenType.EOF);
+
+            Token token = scanToken();
+            if (token != null) return token;
         }
+    }
+
+    List<Token> scanTokens() {
+        List<Token> tokens = new ArrayList<>();
+        Token token;
+
+        do {
+            token = nextToken();
+            tokens.add(token);
+        } while (token.type != TokenType.EOF);
 
-        tokens.add(new Token(TokenType.EOF, "",null,line));
         return tokens;
     }
 
-    private void scanToken() {
+    private Token scanToken() {
         char c = advance();
         switch (c) {
-            case '(': addToken(TokenType.LEFT_PAREN); break;
-            case ')': addToken(TokenType.RIGHT_PAREN); break;
-            case '{': addToken(TokenType.LEFT_BRACE); break;
-            case '}': addToken(TokenType.RIGHT_BRACE); break;
-            case ',': addToken(TokenType.COMMA); break;
-            case '.': addToken(TokenType.DOT); break;
-            case '-': addToken(TokenType.MINUS); break;
-            case '+': addToken(TokenType.PLUS); break;
-            case ';': addToken(TokenType.SEMICOLON); break;
-            case '*': addToken(TokenType.STAR); break;
+            case '(': return makeToken(TokenType.LEFT_PAREN);
+            case ')': return makeToken(TokenType.RIGHT_PAREN);
+            case '{': return makeToken(TokenType.LEFT_BRACE);
+            case '}': return makeToken(TokenType.RIGHT_BRACE);
+            case ',': return makeToken(TokenType.COMMA);
+            case '.': return makeToken(TokenType.DOT);
+            case '-': return makeToken(TokenType.MINUS);
+            case '+': return makeToken(TokenType.PLUS);
+            case ';': return makeToken(TokenType.SEMICOLON);
+            case '*': return makeToken(TokenType.STAR);
             case '!':
-                addToken(match('=') ? TokenType.BANG_EQUAL : TokenType.BANG);
-                break;
+                return makeToken(match('=') ? TokenType.BANG_EQUAL : TokenType.BANG);
             case '=':
-                addToken(match('=') ? TokenType.EQUAL_EQUAL : TokenType.EQUAL);
-                break;
+                return makeToken(match('=') ? TokenType.EQUAL_EQUAL : TokenType.EQUAL);
             case '<':
-                addToken(match('=') ? TokenType.LESS_EQUAL : TokenType.LESS);
-                break;
+                return makeToken(match('=') ? TokenType.LESS_EQUAL : TokenType.LESS);
             case '>':
-                addToken(match('=') ? TokenType.GREATER_EQUAL : TokenType.GREATER);
-                break;
+                return makeToken(match('=') ? TokenType.GREATER_EQUAL : TokenType.GREATER);
             case '/':
                 if (match('/')) {
                     // A comment goes untill the end of the line.
                     while (peek() != '\n' && !isAtEnd()) advance();
-                } else {
-                    addToken(TokenType.SLASH);
+                    return null;
                 }
-                break;
+                return makeToken(TokenType.SLASH);
 
             case ' ':
             case '\r':
             case '\t':
                 // Ignore whitespace.
-                break;
+                return null;
 
             case '\n':
                 line++;
-                break;
+                return null;
 
-            case '"': string(); break;
+            case '"': return string();
 
             default:
                 if (isDigit(c)) {
-                    number();
-                } else if (isAlpha(c)){
-                    identifier();
-                } else {
-                    Lox.error(line, "Unexpected character.");
+                    return number();
+                } else if (isAlpha(c)) {
+                    return identifier();
                 }
-                break;
+
+                // A character outside of ASCII takes several bytes, it is reported once.
+                while ((peek() & 0xC0) == 0x80) advance();
+                Lox.error(line, "Unexpected character.");
+                return null;
         }
     }
 
-    private void identifier() {
+    private Token identifier() {
         while (isAlphaNumeric(peek())) advance();
 
-        String text = source.substring(start, current);
-        TokenType type = keywords.get(text);
-        if (type == null) type = TokenType.IDENTIFIER;
-        addToken(type);
+        return makeToken(identifierType());
+    }
+
+    private TokenType identifierType() {
+        // Keywords are found by their letters, no String is made for the identifier.
+        switch (source[start]) {
+            case 'a': return checkKeyword(1, "nd", TokenType.AND);
+            case 'c': return checkKeyword(1, "lass", TokenType.CLASS);
+            case 'e': return checkKeyword(1, "lse", TokenType.ELSE);
+            case 'f':
+                if (current - start > 1) {
+                    switch (source[start + 1]) {
+                        case 'a': return checkKeyword(2, "lse", TokenType.FALSE);
+                        case 'o': return checkKeyword(2, "r", TokenType.FOR);
+                        case 'u': return checkKeyword(2, "n", TokenType.FUN);
+                    }
+                }
+                break;
+            case 'i': return checkKeyword(1, "f", TokenType.IF);
+            case 'n': return checkKeyword(1, "il", TokenType.NIL);
+            case 'o': return checkKeyword(1, "r", TokenType.OR);
+            case 'p': return checkKeyword(1, "rint", TokenType.PRINT);
+            case 'r': return checkKeyword(1, "eturn", TokenType.RETURN);
+            case 's': return checkKeyword(1, "uper", TokenType.SUPER);
+            case 't':
+                if (current - start > 1) {
+                    switch (source[start + 1]) {
+                        case 'h': return checkKeyword(2, "is", TokenType.THIS);
+                        case 'r': return checkKeyword(2, "ue", TokenType.TRUE);
+                    }
+                }
+                break;
+            case 'v': return checkKeyword(1, "ar", TokenType.VAR);
+            case 'w': return checkKeyword(1, "hile", TokenType.WHILE);
+        }
+
+        return TokenType.IDENTIFIER;
+    }
 
+    private TokenType checkKeyword(int offset, String rest, TokenType type) {
+        if (current - start != offset + rest.length()) return TokenType.IDENTIFIER;
+
+        for (int i = 0; i < rest.length(); i++) {
+            if (source[start + offset + i] != rest.charAt(i)) return TokenType.IDENTIFIER;
+        }
+
+        return type;
     }
 
     private boolean isAlpha(char c) {
@@ -128,7 +166,7 @@ class Scanner {
         return isAlpha(c) || isDigit(c);
     }
 
-    private void number() {
+    private Token number() {
         while (isDigit(peek())) advance();
 
         // Look for a fractional part.
@@ -139,10 +177,33 @@ class Scanner {
             while (isDigit(peek())) advance();
         }
 
-        addToken(TokenType.NUMBER, Double.parseDouble(source.substring(start, current)));
+        return makeToken(TokenType.NUMBER, parseNumber());
+    }
+
+    private double parseNumber() {
+        long digits = 0;
+        int count = 0;
+        int decimals = -1;
+
+        for (int i = start; i < current; i++) {
+            if (source[i] == '.') {
+                decimals = 0;
+                continue;
+            }
+            digits = digits * 10 + (source[i] - '0');
+            count++;
+            if (decimals >= 0) decimals++;
+        }
+
+        // Up to 15 digits the number is exact as a double, so one division rounds it the same way as parseDouble.
+        if (count > 15 || decimals >= POWERS_OF_TEN.length) {
+            return Double.parseDouble(new String(source, start, current - start, StandardCharsets.US_ASCII));
+        }
+
+        return decimals > 0 ? digits / POWERS_OF_TEN[decimals] : digits;
     }
 
-    private void string() {
+    private Token string() {
         while (peek() != '"' && !isAtEnd()) {
             if (peek() == '\n') line++;
             advance();
@@ -150,20 +211,19 @@ class Scanner {
 
         if (isAtEnd()) {
             Lox.error(line, "Unterminated string.");
-            return;
+            return null;
         }
 
         // The closing ".
         advance();
 
-        // Trim the surrounding quotes.
-        String value = source.substring(start + 1, current - 1);
-        addToken(TokenType.STRING, value);
+        // The value is made from the lexeme only when the parser asks for it.
+        return makeToken(TokenType.STRING);
     }
 
     private boolean match(char expected) {
         if (isAtEnd()) return false;
-        if (source.charAt(current) != expected) return false;
+        if (source[current] != expected) return false;
 
         current++;
         return true;
@@ -171,12 +231,12 @@ class Scanner {
 
     private char peek() {
         if (isAtEnd()) return '\0';
-        return source.charAt(current);
+        return (char) (source[current] & 0xFF);
     }
 
     private char peekNext() {
-        if (current + 1 >= source.length()) return '\0';
-        return source.charAt(current + 1);
+        if (current + 1 >= source.length) return '\0';
+        return (char) (source[current + 1] & 0xFF);
     }
 
     private boolean isDigit(char c) {
@@ -184,19 +244,18 @@ class Scanner {
     }
 
     private boolean isAtEnd() {
-        return current >= source.length();
+        return current >= source.length;
     }
 
     private char advance() {
-        return source.charAt(current++);
+        return (char) (source[current++] & 0xFF);
     }
 
-    private void addToken(TokenType type) {
-        addToken(type, null);
+    private Token makeToken(TokenType type) {
+        return makeToken(type, 0);
     }
 
-    private void addToken(TokenType type, Object literal) {
-        String text = source.substring(start, current);
-        tokens.add(new Token(type, text, literal, line));
+    private Token makeToken(TokenType type, double number) {
+        return new Token(type, source, start, current - start, number, line);
     }
 }
@@ -0,0 +1,132 @@
+package main.jlox;
+
+import java.io.IOException;
+import java.lang.management.ManagementFactory;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+
+
+// Scanner throughput in the manner of JMH: every iteration scans the whole source,
+// the first ones warm up the JIT and only the rest are measured.
+public class ScannerBenchmark {
+    private static final int WARMUP_ITERATIONS = 5;
+    private static final int MEASURED_ITERATIONS = 10;
+
+    private static final String SAMPLE =
+            "// Compute the sum of squares.\n" +
+            "fun sumOfSquares(n) {\n" +
+            "    var total = 0;\n" +
+            "    for (var i = 0; i < n; i = i + 1) {\n" +
+            "        total = total + i * i;\n" +
+            "    }\n" +
+            "    return total;\n" +
+            "}\n" +
+            "\n" +
+            "class Point {\n" +
+            "    init(x, y) {\n" +
+            "        this.x = x;\n" +
+            "        this.y = y;\n" +
+            "    }\n" +
+            "}\n" +
+            "\n" +
+            "var limit = 1000.5;\n" +
+            "if (sumOfSquares(10) >= limit and !false or nil == nil) {\n" +
+            "    print \"sum of squares is large enough\";\n" +
+            "} else {\n" +
+            "    print (-123) * 45.67 / (1 + 2) != 3;\n" +
+            "}\n";
+
+    // Keeps the results alive, so the JIT can't drop the work.
+    static long sink;
+
+    public static void main(String[] args) throws IOException {
+        if (args.length > 1) {
+            System.out.println("Usage: scanner_benchmark [megabytes | script]");
+            System.exit(64);
+        }
+
+        byte[] source;
+        if (args.length == 1 && !args[0].matches("[0-9]+")) {
+            source = Files.readAllBytes(Paths.get(args[0]));
+        } else {
+            source = generate(args.length == 1 ? Integer.parseInt(args[0]) : 16);
+        }
+
+        System.out.printf("source: %.1f MB, %d warmup and %d measured iterations%n",
+                source.length / 1e6, WARMUP_ITERATIONS, MEASURED_ITERATIONS);
+
+        measure("stream", source, Mode.STREAM);
+        measure("list", source, Mode.LIST);
+        measure("lexemes", source, Mode.LEXEMES);
+    }
+
+    private enum Mode {
+        // Tokens are pulled one by one, as the parser does.
+        STREAM,
+        // All tokens are kept in a list first.
+        LIST,
+        // Every token gets a String of its lexeme, as the scanner did before.
+        LEXEMES
+    }
+
+    private static byte[] generate(int megabytes) {
+        byte[] sample = SAMPLE.getBytes(StandardCharsets.UTF_8);
+        byte[] source = new byte[megabytes * 1024 * 1024 / sample.length * sample.length];
+
+        for (int i = 0; i < source.length; i += sample.length) {
+            System.arraycopy(sample, 0, source, i, sample.length);
+        }
+
+        return source;
+    }
+
+    private static void measure(String name, byte[] source, Mode mode) {
+        com.sun.management.ThreadMXBean threads =
+                (com.sun.management.ThreadMXBean) ManagementFactory.getThreadMXBean();
+        long thread = Thread.currentThread().getId();
+        long tokens = 0;
+
+        for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+            scan(source, mode);
+        }
+
+        long allocated = threads.getThreadAllocatedBytes(thread);
+        long time = System.nanoTime();
+        for (int i = 0; i < MEASURED_ITERATIONS; i++) {
+            tokens += scan(source, mode);
+        }
+        time = System.nanoTime() - time;
+        allocated = threads.getThreadAllocatedBytes(thread) - allocated;
+
+        double seconds = time / 1e9;
+        System.out.printf("%-8s %,14.0f tokens/s %8.1f MB/s source %8.1f MB/s allocated %6.1f bytes/token%n",
+                name,
+                tokens / seconds,
+                (double) source.length * MEASURED_ITERATIONS / seconds / 1e6,
+                allocated / seconds / 1e6,
+                (double) allocated / tokens);
+    }
+
+    private static long scan(byte[] source, Mode mode) {
+        Scanner scanner = new Scanner(source);
+        long count = 0;
+
+        if (mode == Mode.LIST) {
+            for (Token token : scanner.scanTokens()) {
+                sink += token.length;
+                count++;
+            }
+            return count;
+        }
+
+        Token token;
+        do {
+            token = scanner.nextToken();
+            sink += mode == Mode.LEXEMES ? token.lexeme().length() : token.length;
+            count++;
+        } while (token.type != TokenType.EOF);
+
+        return count;
+    }
+}
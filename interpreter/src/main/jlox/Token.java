@@ -1,19 +1,47 @@
 package main.jlox;
 
+import java.nio.charset.StandardCharsets;
+
 class Token {
     final TokenType type;
-    final String lexeme;
-    final Object literal;
+    // The lexeme is a slice of the source, a String is made only when it's asked for.
+    final byte[] source;
+    final int start;
+    final int length;
+    final double number;
     final int line;
 
-    Token(TokenType type, String lexeme, Object literal, int line) {
+    Token(TokenType type, byte[] source, int start, int length, double number, int line) {
         this.type = type;
-        this.lexeme = lexeme;
-        this.literal = literal;
+        this.source = source;
+        this.start = start;
+        this.length = length;
+        this.number = number;
         this.line = line;
     }
 
+    Token(TokenType type, String lexeme, int line) {
+        this(type, lexeme.getBytes(StandardCharsets.UTF_8), line);
+    }
+
+    private Token(TokenType type, byte[] lexeme, int line) {
+        this(type, lexeme, 0, lexeme.length, 0, line);
+    }
+
+    String lexeme() {
+        return new String(source, start, length, StandardCharsets.UTF_8);
+    }
+
+    Object literal() {
+        switch (type) {
+            case NUMBER: return number;
+            // Trim the surrounding quotes.
+            case STRING: return new String(source, start + 1, length - 2, StandardCharsets.UTF_8);
+            default: return null;
+        }
+    }
+
     public String toString() {
-        return type + " " + lexeme + " " + literal;
+        return type + " " + lexeme() + " " + literal();
     }
 }
@@ -0,0 +1,153 @@
+package main.jlox;
+
+// Stack machine for the bytecode of the Compiler.
+// A slot of the stack is a number in `numbers` when its entry in `objects` is null,
+// otherwise the entry is the value: NIL, Boolean or String. So arithmetic and comparisons
+// work on unboxed doubles, and only the result of the whole expression is boxed.
+class VM {
+    private static final Object NIL = new Object();
+
+    private double[] numbers = new double[64];
+    private Object[] objects = new Object[64];
+
+    void interpret(Chunk chunk) {
+        try {
+            Object value = run(chunk);
+            System.out.println(Interpreter.stringify(value));
+        } catch (RuntimeError error) {
+            Lox.runtimeError(error);
+        }
+    }
+
+    Object run(Chunk chunk) {
+        // The compiler knows how deep the stack gets, so pushes are not checked.
+        if (chunk.maxStack > numbers.length) {
+            numbers = new double[chunk.maxStack];
+            objects = new Object[chunk.maxStack];
+        }
+
+        byte[] code = chunk.code;
+        double[] numbers = this.numbers;
+        Object[] objects = this.objects;
+        int ip = 0;
+        int top = 0;
+
+        for (;;) {
+            switch (code[ip++]) {
+                case OpCode.NUMBER:
+                    numbers[top] = chunk.numbers[((code[ip] & 0xFF) << 8) | (code[ip + 1] & 0xFF)];
+                    objects[top++] = null;
+                    ip += 2;
+                    break;
+                case OpCode.OBJECT:
+                    objects[top++] = chunk.objects[((code[ip] & 0xFF) << 8) | (code[ip + 1] & 0xFF)];
+                    ip += 2;
+                    break;
+                case OpCode.NIL:
+                    objects[top++] = NIL;
+                    break;
+                case OpCode.TRUE:
+                    objects[top++] = Boolean.TRUE;
+                    break;
+                case OpCode.FALSE:
+                    objects[top++] = Boolean.FALSE;
+                    break;
+
+                case OpCode.ADD:
+                    top--;
+                    if (objects[top - 1] == null && objects[top] == null) {
+                        numbers[top - 1] += numbers[top];
+                    } else if (objects[top - 1] instanceof String && objects[top] instanceof String) {
+                        objects[top - 1] = (String) objects[top - 1] + (String) objects[top];
+                    } else {
+                        throw error(chunk, ip, "Operands must be two numbers or two strings.");
+                    }
+                    break;
+                case OpCode.SUBTRACT:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    numbers[top - 1] -= numbers[top];
+                    break;
+                case OpCode.MULTIPLY:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    numbers[top - 1] *= numbers[top];
+                    break;
+                case OpCode.DIVIDE:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    if (numbers[top] == 0) throw error(chunk, ip, "Division by zero.");
+                    numbers[top - 1] /= numbers[top];
+                    break;
+                case OpCode.NEGATE:
+                    if (objects[top - 1] != null) throw error(chunk, ip, "Operand must be a number.");
+                    numbers[top - 1] = -numbers[top - 1];
+                    break;
+
+                case OpCode.NOT:
+                    objects[top - 1] = isTruthy(objects[top - 1]) ? Boolean.FALSE : Boolean.TRUE;
+                    break;
+                case OpCode.EQUAL:
+                    top--;
+                    objects[top - 1] = isEqual(top - 1, top) ? Boolean.TRUE : Boolean.FALSE;
+                    break;
+                case OpCode.NOT_EQUAL:
+                    top--;
+                    objects[top - 1] = isEqual(top - 1, top) ? Boolean.FALSE : Boolean.TRUE;
+                    break;
+                case OpCode.GREATER:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    objects[top - 1] = numbers[top - 1] > numbers[top] ? Boolean.TRUE : Boolean.FALSE;
+                    break;
+                case OpCode.GREATER_EQUAL:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    objects[top - 1] = numbers[top - 1] >= numbers[top] ? Boolean.TRUE : Boolean.FALSE;
+                    break;
+                case OpCode.LESS:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    objects[top - 1] = numbers[top - 1] < numbers[top] ? Boolean.TRUE : Boolean.FALSE;
+                    break;
+                case OpCode.LESS_EQUAL:
+                    top--;
+                    checkNumbers(chunk, ip, top);
+                    objects[top - 1] = numbers[top - 1] <= numbers[top] ? Boolean.TRUE : Boolean.FALSE;
+                    break;
+
+                case OpCode.RETURN:
+                    top--;
+                    if (objects[top] == null) return numbers[top];
+                    return objects[top] == NIL ? null : objects[top];
+
+                default:
+                    throw new IllegalStateException("Unknown opcode " + code[ip - 1] + ".");
+            }
+        }
+    }
+
+    // Operands of a binary operator are the slots `top - 1` and `top`.
+    private void checkNumbers(Chunk chunk, int ip, int top) {
+        if (objects[top - 1] == null && objects[top] == null) return;
+        throw error(chunk, ip, "Operands must be numbers.");
+    }
+
+    private boolean isEqual(int a, int b) {
+        if (objects[a] == null && objects[b] == null) return numbers[a] == numbers[b];
+        if (objects[a] == null || objects[b] == null) return false;
+
+        return objects[a].equals(objects[b]);
+    }
+
+    private static boolean isTruthy(Object object) {
+        // A number slot has no object, and numbers are true.
+        if (object == NIL) return false;
+        if (object instanceof Boolean) return (boolean) object;
+        return true;
+    }
+
+    private static RuntimeError error(Chunk chunk, int ip, String message) {
+        return new RuntimeError(chunk.lines[ip - 1], message);
+    }
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Tests of the Java interpreter
+# Compiles the sources and runs the checks, exits with 1 if any of them fails
+
+set -e
+
+cd "$(dirname "$0")"
+
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+javac -d "$out" main/jlox/*.java
+java -cp "$out" main.jlox.ExpressionTest
@@ -0,0 +1,73 @@
+#!/bin/bash
+# Benchmark of the shell
+# Runs pipelines of `true` of every length, then a long script of builtins to measure
+# the startup time and the cost of one line, prints one JSON object per run
+#
+# Environment:
+#   STAGES     pipeline lengths (default: "1 2 8 32 128")
+#   PROCESSES  processes started per length (default: 4096)
+#   LINES      lines of the script (default: 100000)
+#   STARTS     shell starts to measure the startup time (default: 100)
+
+set -e
+
+STAGES=${STAGES:-"1 2 8 32 128"}
+PROCESSES=${PROCESSES:-4096}
+LINES=${LINES:-100000}
+STARTS=${STARTS:-100}
+
+cd "$(dirname "$0")"
+make -s all
+
+script=$(mktemp)
+trap 'rm -f "$script"' EXIT
+
+for stages in $STAGES; do
+    pipelines=$(( (PROCESSES + stages - 1) / stages ))
+    pipeline="true$(printf ' | true%.0s' $(seq 2 "$stages"))"
+
+    for _ in $(seq "$pipelines"); do
+        echo "$pipeline"
+    done > "$script"
+
+    start=$(date +%s%N)
+    ./shell < "$script" > /dev/null
+    end=$(date +%s%N)
+
+    awk -v stages="$stages" -v pipelines="$pipelines" -v ns=$((end - start)) 'BEGIN {
+        printf "{\"stages\": %d, \"pipelines\": %d, \"seconds\": %.3f, \"processes_per_second\": %.0f, \"pipelines_per_second\": %.0f}\n",
+               stages, pipelines, ns / 1e9, stages * pipelines / (ns / 1e9), pipelines / (ns / 1e9)
+    }'
+done
+
+# Startup: the shell runs an empty script
+: > "$script"
+start=$(date +%s%N)
+for _ in $(seq "$STARTS"); do
+    ./shell "$script" > /dev/null
+done
+end=$(date +%s%N)
+
+awk -v starts="$STARTS" -v ns=$((end - start)) 'BEGIN {
+    printf "{\"startup_us\": %.0f}\n", ns / starts / 1e3
+}'
+
+# Lines: builtins only, so the time is spent in the shell itself
+for _ in $(seq "$LINES"); do
+    echo "plus 1 2"
+done > "$script"
+
+for mode in file stdin; do
+    start=$(date +%s%N)
+    if [ "$mode" = file ]; then
+        ./shell "$script" > /dev/null
+    else
+        ./shell < "$script" > /dev/null
+    fi
+    end=$(date +%s%N)
+
+    awk -v mode="$mode" -v lines="$LINES" -v ns=$((end - start)) 'BEGIN {
+        printf "{\"script\": \"%s\", \"lines\": %d, \"seconds\": %.3f, \"ns_per_line\": %.0f}\n",
+               mode, lines, ns / 1e9, ns / lines
+    }'
+done
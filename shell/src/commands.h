@@ -3,6 +3,7 @@
  *
  * This file contains all the builtin functions, if you want you can easily add them simply by writing them here
  * To do this, you need to add them to the list of `builtint_str` and to the list of functions `buildin_func`
+ * The list is searched with binary search, so keep the names sorted and the functions in the same order
  * Of course, you need to add the implementation of the corresponding function
  * */
 
@@ -28,28 +29,67 @@
 #endif
 
 
+#ifndef _FCNTL_H
+#include <fcntl.h>
+#endif
+
+
+#ifndef _SYS_POLL_H
+#include <poll.h>
+#endif
+
+
+
+#define PARALLEL_BUFSIZE    65536           /* Read size of the output of `parallel` commands */
+#define PARALLEL_STREAMS    2               /* Standard output and error of `parallel` commands */
+
+
 
 /* Function Declarations for builtin shell commands */
 int shell_cd(char **args);
 int shell_help(char **args);
 int shell_exit(char **args);
 int shell_plus(char **args);
+int shell_hash(char **args);
+int shell_jobs(char **args);
+int shell_fg(char **args);
+int shell_bg(char **args);
+int shell_wait(char **args);
+int shell_parallel(char **args);
+int shell_time(char **args);
 
+/* Command line execution of the shell, used by `time` */
+int shell_execute(char **args);
 
 
-/* List of buildtin commands, followed by their corresponding functions */
+
+/* List of buildtin commands sorted by name, followed by their corresponding functions */
 char *builtin_str[] = {
+    "bg",
     "cd",
+    "exit",
+    "fg",
+    "hash",
     "help",
+    "jobs",
+    "parallel",
     "plus",
-    "exit"
+    "time",
+    "wait"
 };
 
 int (*builtin_func[]) (char **) = {
+    &shell_bg,
     &shell_cd,
+    &shell_exit,
+    &shell_fg,
+    &shell_hash,
     &shell_help,
+    &shell_jobs,
+    &shell_parallel,
     &shell_plus,
-    &shell_exit
+    &shell_time,
+    &shell_wait
 };
 
 
@@ -65,6 +105,30 @@ int shell_num_builtins(void) {
 
 
 
+/**
+ * Compare the command name with the builtin name, for `bsearch`
+ * @param void* name - command name
+ * @param void* builtin - element of `builtin_str`
+ * @return int - result of `strcmp`
+ * */
+int shell_compare_builtin(const void *name, const void *builtin) {
+    return strcmp(name, *(char * const *)builtin);
+}
+
+
+
+/**
+ * Find the builtin command
+ * @param char* name - command name
+ * @return int - index in `builtin_str`, or -1 if the command is not builtin
+ * */
+int shell_find_builtin(char *name) {
+    char **builtin = bsearch(name, builtin_str, shell_num_builtins(), sizeof(char *), shell_compare_builtin);
+    return builtin ? builtin - builtin_str : -1;
+}
+
+
+
 /* Builtin function implementation */
 
 
@@ -153,3 +217,483 @@ int shell_plus(char **args) {
 int shell_exit(char **args) {
     return 0;
 }
+
+
+
+/**
+ * Hash command, shows or clears the table of resolved command paths
+ * `hash` prints the table, `hash -r` forgets all commands, `hash name...` resolves the commands
+ * @param char** args - arguments for the command
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_hash(char **args) {
+    int i;
+
+    if (args[1] == NULL) {
+        path_print();
+    } else if (strcmp(args[1], "-r") == 0) {
+        path_clear();
+    } else {
+        for (i = 1; args[i] != NULL; i++) {
+            if (!path_lookup(args[i])) {
+                fprintf(stderr, "shell: hash: %s: not found\n", args[i]);
+            }
+        }
+    }
+    return 1;
+}
+
+
+
+/**
+ * Jobs command, prints the jobs and forgets the finished ones
+ * @param char** args - arguments for the command
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_jobs(char **args) {
+    sigset_t old;
+    int i;
+
+    (void)args;
+    jobs_block(&old);
+    for (i = 0; i < JOBS_MAX; i++) {
+        if (jobs_table[i].id) {
+            jobs_print(&jobs_table[i]);
+            if (jobs_state(&jobs_table[i]) == JOB_DONE) {
+                jobs_remove(&jobs_table[i]);
+            }
+        }
+    }
+    jobs_unblock(&old);
+    return 1;
+}
+
+
+
+/**
+ * Fg command, continues the job in the foreground and waits for it
+ * @param char** args - arguments for the command, `%n` or the current job
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_fg(char **args) {
+    struct job *job;
+    sigset_t old;
+
+    jobs_block(&old);
+    job = jobs_find(args[1]);
+    if (!job) {
+        fprintf(stderr, "shell: fg: %s: no such job\n", args[1] ? args[1] : "current");
+    } else {
+        printf("%s\n", job->command);
+        fflush(stdout);
+        if (jobs_control) {
+            tcsetpgrp(STDIN_FILENO, job->pgid);
+        }
+        jobs_continue(job);
+        jobs_foreground(job, &old, NULL);
+    }
+    jobs_unblock(&old);
+    return 1;
+}
+
+
+
+/**
+ * Bg command, continues the stopped job in the background
+ * @param char** args - arguments for the command, `%n` or the current job
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_bg(char **args) {
+    struct job *job;
+    sigset_t old;
+
+    jobs_block(&old);
+    job = jobs_find(args[1]);
+    if (!job) {
+        fprintf(stderr, "shell: bg: %s: no such job\n", args[1] ? args[1] : "current");
+    } else {
+        jobs_continue(job);
+        printf("[%d] %s &\n", job->id, job->command);
+    }
+    jobs_unblock(&old);
+    return 1;
+}
+
+
+
+/**
+ * Wait command, waits for the given jobs or for all of them
+ * @param char** args - arguments for the command, `%n` or process ids
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_wait(char **args) {
+    struct job *job;
+    sigset_t old;
+    int i;
+
+    jobs_block(&old);
+    if (args[1] == NULL) {
+        for (i = 0; i < JOBS_MAX; i++) {
+            if (jobs_table[i].id) {
+                jobs_wait(&jobs_table[i], &old);
+            }
+        }
+    }
+    for (i = 1; args[i] != NULL; i++) {
+        job = jobs_find(args[i]);
+        if (!job) {
+            fprintf(stderr, "shell: wait: %s: no such job\n", args[i]);
+        } else {
+            jobs_wait(job, &old);
+        }
+    }
+    jobs_unblock(&old);
+    return 1;
+}
+
+
+
+/**
+ * Time command, prints wall, user and sys time, max RSS, context switches and page faults of the command
+ * `time` at the start of a line is handled by `shell_execute` and measures the whole pipeline,
+ * so this one runs only as a forked stage of a pipeline, e.g. `ls | time sort`
+ * @param char** args - arguments for the command, the command line to measure
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_time(char **args) {
+    // Forked stage has no terminal to give away and must reap its own children
+    jobs_control = 0;
+    jobs_init(0);
+    return shell_execute(args);
+}
+
+
+
+/**
+ * Write the whole buffer to the standard output or error of the shell
+ * @param int fd - `STDOUT_FILENO` or `STDERR_FILENO`
+ * @param char* buffer - data
+ * @param size_t length - data length
+ * @return void - nothing
+ * */
+void parallel_write(int fd, char *buffer, size_t length) {
+    ssize_t n;
+
+    while (length > 0) {
+        n = write(fd, buffer, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return;
+        }
+        buffer += n;
+        length -= n;
+    }
+}
+
+
+
+/**
+ * Replace all `{}` in the word with the input
+ * @param char* word - command word
+ * @param char* input - input of the command
+ * @return char* result - allocated word, or NULL if the word has no `{}`
+ * */
+char *parallel_replace(char *word, char *input) {
+    size_t input_length = strlen(input);
+    size_t length = strlen(word) + 1;
+    char *result, *c, *r;
+
+    for (c = strstr(word, "{}"); c != NULL; c = strstr(c + 2, "{}")) {
+        length += input_length;
+    }
+    if (length == strlen(word) + 1) {
+        return NULL;
+    }
+
+    result = malloc(length);
+    if (!result) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (c = word, r = result; *c != '\0'; ) {
+        if (c[0] == '{' && c[1] == '}') {
+            memcpy(r, input, input_length);
+            r += input_length;
+            c += 2;
+        } else {
+            *r++ = *c++;
+        }
+    }
+    *r = '\0';
+
+    return result;
+}
+
+
+
+/**
+ * Start the command for one input, its standard output and error go to pipes
+ * @param char** command - command words, `{}` is replaced with the input, else the input is appended
+ * @param int words - number of command words
+ * @param char* input - input of the command
+ * @param int* fds - read ends of the output and error pipes, -1 on error
+ * @return pid_t pid - started process or -1 on error
+ * */
+pid_t parallel_spawn(char **command, int words, char *input, int *fds) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    char **argv = malloc((words + 2) * sizeof(char *));
+    char **replaced = malloc(words * sizeof(char *));
+    int replacements = 0;
+    pid_t pid = -1;
+    int pipefd[PARALLEL_STREAMS][2];
+    char *path;
+    int error, i;
+
+    fds[0] = fds[1] = -1;
+    if (!argv || !replaced) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < words; i++) {
+        replaced[i] = parallel_replace(command[i], input);
+        argv[i] = replaced[i] ? replaced[i] : command[i];
+        replacements += replaced[i] != NULL;
+    }
+    argv[words] = replacements ? NULL : input;
+    argv[words + 1] = NULL;
+
+    path = path_lookup(argv[0]);
+    if (!path) {
+        fprintf(stderr, "shell: %s: command not found\n", argv[0]);
+    } else if (pipe2(pipefd[0], O_CLOEXEC) < 0) {
+        perror("shell");
+    } else if (pipe2(pipefd[1], O_CLOEXEC) < 0) {
+        perror("shell");
+        close(pipefd[0][0]);
+        close(pipefd[0][1]);
+    } else {
+        // Commands share the terminal with the shell and never read its input
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipefd[0][1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, pipefd[1][1], STDERR_FILENO);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        jobs_spawn_attributes(&attr, -1);
+
+        error = posix_spawn(&pid, path, &actions, &attr, argv, environ);
+        for (i = 0; i < PARALLEL_STREAMS; i++) {
+            close(pipefd[i][1]);
+            if (error) {
+                close(pipefd[i][0]);
+            } else {
+                fds[i] = pipefd[i][0];
+            }
+        }
+        if (error) {
+            fprintf(stderr, "shell: %s: %s\n", argv[0], strerror(error));
+            pid = -1;
+        }
+
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+    }
+
+    for (i = 0; i < words; i++) {
+        free(replaced[i]);
+    }
+    free(replaced);
+    free(argv);
+    return pid;
+}
+
+
+
+/* Standard output or error of a command of `parallel` */
+struct parallel_stream {
+    int fd;                                 /* Read end of the pipe, -1 when it is closed */
+    char *output;                           /* Output kept until the previous commands are printed */
+    size_t length;
+    size_t size;
+};
+
+
+
+/* Command of `parallel` started for one input */
+struct parallel_task {
+    pid_t pid;
+    int open;                               /* Number of streams not closed yet */
+    struct parallel_stream streams[PARALLEL_STREAMS];   /* Stream `i` goes to descriptor `STDOUT_FILENO + i` */
+};
+
+
+
+/**
+ * Run the command for every input, keeping `jobs` of them running
+ * Output and errors of the first unfinished command are printed as they come, those of the next ones are kept
+ * until all commands before them finish, so outputs are never mixed and come in the order of the inputs
+ * @param char** command - command words
+ * @param int words - number of command words
+ * @param char** inputs - inputs of the commands
+ * @param int count - number of inputs
+ * @param int jobs - number of commands running at the same time
+ * @return int failed - number of commands failed
+ * */
+int parallel_run(char **command, int words, char **inputs, int count, int jobs) {
+    struct parallel_task *tasks = calloc(count, sizeof(struct parallel_task));
+    struct pollfd *fds = malloc(jobs * PARALLEL_STREAMS * sizeof(struct pollfd));
+    int *ready = malloc(jobs * PARALLEL_STREAMS * sizeof(int));
+    char buffer[PARALLEL_BUFSIZE];
+    int spawned[PARALLEL_STREAMS];
+    struct parallel_stream *stream;
+    struct parallel_task *task;
+    int next = 0, head = 0, running = 0, failed = 0;
+    int n, i, j, status;
+    sigset_t old;
+    ssize_t length;
+
+    if (!tasks || !fds || !ready) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Commands are reaped here, not by the handler of the job table: `SIGCHLD` stays blocked
+    // from the first command started until the last one is reaped, so the handler never takes their statuses
+    fflush(stdout);
+    jobs_block(&old);
+
+    while (1) {
+        while (running < jobs && next < count) {
+            task = &tasks[next++];
+            task->pid = parallel_spawn(command, words, inputs[next - 1], spawned);
+            for (j = 0; j < PARALLEL_STREAMS; j++) {
+                task->streams[j].fd = spawned[j];
+            }
+            if (task->pid < 0) {
+                failed++;
+            } else {
+                task->open = PARALLEL_STREAMS;
+                running++;
+            }
+        }
+
+        // The next command becomes the printed one, its kept output and errors go first
+        while (head < next && tasks[head].open == 0) {
+            for (j = 0; j < PARALLEL_STREAMS; j++) {
+                free(tasks[head].streams[j].output);
+            }
+            head++;
+            for (j = 0; head < next && j < PARALLEL_STREAMS; j++) {
+                stream = &tasks[head].streams[j];
+                parallel_write(STDOUT_FILENO + j, stream->output, stream->length);
+                free(stream->output);
+                stream->output = NULL;
+            }
+        }
+        if (head == count) {
+            break;
+        }
+
+        n = 0;
+        for (i = head; i < next; i++) {
+            for (j = 0; j < PARALLEL_STREAMS; j++) {
+                if (tasks[i].streams[j].fd >= 0) {
+                    fds[n].fd = tasks[i].streams[j].fd;
+                    fds[n].events = POLLIN;
+                    ready[n++] = i * PARALLEL_STREAMS + j;
+                }
+            }
+        }
+
+        if (poll(fds, n, -1) < 0) {
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            task = &tasks[ready[i] / PARALLEL_STREAMS];
+            j = ready[i] % PARALLEL_STREAMS;
+            stream = &task->streams[j];
+            length = read(stream->fd, buffer, sizeof(buffer));
+
+            if (length > 0 && task == &tasks[head]) {
+                parallel_write(STDOUT_FILENO + j, buffer, length);
+            } else if (length > 0) {
+                if (stream->length + length > stream->size) {
+                    stream->size = (stream->length + length) * 2;
+                    stream->output = realloc(stream->output, stream->size);
+                    if (!stream->output) {
+                        fprintf(stderr, "shell: allocation error\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                memcpy(stream->output + stream->length, buffer, length);
+                stream->length += length;
+            } else if (length == 0 || errno != EINTR) {
+                close(stream->fd);
+                stream->fd = -1;
+
+                // End of both streams: the command has finished or is about to
+                if (--task->open == 0) {
+                    waitpid(task->pid, &status, 0);
+                    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        failed++;
+                    }
+                    running--;
+                }
+            }
+        }
+    }
+
+    jobs_unblock(&old);
+    free(ready);
+    free(fds);
+    free(tasks);
+    return failed;
+}
+
+
+
+/**
+ * Parallel command, runs the command for every argument after `:::`, N commands at the same time
+ * `parallel -j N command args ::: input...`, `{}` in the command is replaced with the input
+ * @param char** args - arguments for the command
+ * @return 1 - this means that command is fine and running without terminating
+ * */
+int shell_parallel(char **args) {
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int words = 0, count = 0, failed;
+    char **command, **inputs;
+    int i = 1;
+
+    if (args[1] != NULL && strcmp(args[1], "-j") == 0 && args[2] != NULL) {
+        jobs = atoi(args[2]);
+        i = 3;
+    }
+
+    command = &args[i];
+    for (; args[i] != NULL && strcmp(args[i], ":::") != 0; i++) {
+        words++;
+    }
+
+    if (words == 0 || args[i] == NULL || jobs < 1) {
+        fprintf(stderr, "shell: usage: parallel [-j N] command [args] ::: input...\n");
+        return 1;
+    }
+
+    inputs = &args[i + 1];
+    while (inputs[count] != NULL) {
+        count++;
+    }
+
+    failed = parallel_run(command, words, inputs, count, jobs);
+    if (failed) {
+        fprintf(stderr, "shell: parallel: %d of %d commands failed\n", failed, count);
+    }
+    return 1;
+}
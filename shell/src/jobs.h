@@ -0,0 +1,531 @@
+/**
+ * JOBS
+ *
+ * This file contains the table of jobs: pipelines started by the shell that are not finished yet
+ * Children are reaped by the `SIGCHLD` handler, which only updates the table, so the shell can wait
+ * for the foreground job and let the background ones run at the same time
+ * The table is changed by the handler, so the shell blocks `SIGCHLD` while it reads or changes it
+ * Children are reaped with `wait4`, so every job also sums the resources used by its processes
+ * */
+
+
+
+#ifndef _ERRNO_H
+#include <errno.h>
+#endif
+
+
+#ifndef _SIGNAL_H
+#include <signal.h>
+#endif
+
+
+#ifndef _SPAWN_H
+#include <spawn.h>
+#endif
+
+
+#ifndef _STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+#ifndef _STRING_H
+#include <string.h>
+#endif
+
+
+#ifndef _UNISTD_H
+#include <unistd.h>
+#endif
+
+
+#ifndef _SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+
+#ifndef _SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
+
+
+#define JOBS_MAX            64              /* Max number of jobs */
+
+
+
+/* State of a process or a whole job */
+enum job_state {
+    JOB_RUNNING,
+    JOB_STOPPED,
+    JOB_DONE
+};
+
+
+/* Process of a job, one for every stage of the pipeline */
+struct job_process {
+    pid_t pid;
+    enum job_state state;
+};
+
+
+/* Pipeline started by the shell */
+struct job {
+    int id;                                 /* Number shown to the user, 0 if the slot is free */
+    pid_t pgid;                             /* Process group, only with job control */
+    struct job_process *processes;
+    int count;                              /* Number of processes */
+    char *command;                          /* Command line to show */
+    unsigned long order;                    /* The latest started or stopped job is the current one */
+    struct rusage usage;                    /* Resources of the finished processes */
+    int status;                             /* Status of the last process from `wait4`, the status of the job */
+};
+
+
+
+/* Table of jobs and the state of job control */
+struct job jobs_table[JOBS_MAX];
+unsigned long jobs_order = 0;
+int jobs_control = 0;                       /* Interactive shell: jobs get own process groups and the terminal */
+pid_t jobs_shell_pgid;
+
+
+
+/**
+ * Update the state of the reaped process
+ * @param pid_t pid - process
+ * @param int status - status from `wait4`
+ * @param struct rusage* usage - resources used by the process, if it has finished
+ * @return void - nothing
+ * */
+void jobs_update(pid_t pid, int status, struct rusage *usage) {
+    int i, j;
+
+    for (i = 0; i < JOBS_MAX; i++) {
+        for (j = 0; jobs_table[i].id && j < jobs_table[i].count; j++) {
+            if (jobs_table[i].processes[j].pid != pid) {
+                continue;
+            }
+            if (WIFSTOPPED(status)) {
+                jobs_table[i].processes[j].state = JOB_STOPPED;
+                jobs_table[i].order = ++jobs_order;
+            } else if (WIFCONTINUED(status)) {
+                jobs_table[i].processes[j].state = JOB_RUNNING;
+            } else {
+                jobs_table[i].processes[j].state = JOB_DONE;
+                profile_add(&jobs_table[i].usage, usage);
+                if (j == jobs_table[i].count - 1) {
+                    jobs_table[i].status = status;
+                }
+            }
+            return;
+        }
+    }
+}
+
+
+
+/**
+ * Reap all children that have changed their state
+ * @param void - nothing on the input
+ * @return void - nothing
+ * */
+void jobs_reap(void) {
+    struct rusage usage;
+    pid_t pid;
+    int status;
+
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0) {
+        jobs_update(pid, status, &usage);
+    }
+}
+
+
+
+/**
+ * `SIGCHLD` handler
+ * @param int sig - signal number
+ * @return void - nothing
+ * */
+void jobs_sigchld(int sig) {
+    int saved_errno = errno;
+
+    (void)sig;
+    jobs_reap();
+    errno = saved_errno;
+}
+
+
+
+/**
+ * Block `SIGCHLD`, the table can be used until it is unblocked
+ * @param sigset_t* old - previous signal mask
+ * @return void - nothing
+ * */
+void jobs_block(sigset_t *old) {
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &set, old);
+}
+
+
+
+/**
+ * Restore the signal mask saved by `jobs_block`
+ * @param sigset_t* old - previous signal mask
+ * @return void - nothing
+ * */
+void jobs_unblock(sigset_t *old) {
+    sigprocmask(SIG_SETMASK, old, NULL);
+}
+
+
+
+/**
+ * Install the `SIGCHLD` handler, an interactive shell also takes the terminal
+ * @param int interactive - the shell reads commands from a terminal
+ * @return void - nothing
+ * */
+void jobs_init(int interactive) {
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = jobs_sigchld;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, NULL);
+
+    if (!interactive) {
+        return;
+    }
+
+    // Wait until the shell is in the foreground
+    while (tcgetpgrp(STDIN_FILENO) != (jobs_shell_pgid = getpgrp())) {
+        kill(-jobs_shell_pgid, SIGTTIN);
+    }
+
+    // Keyboard signals go to the foreground job, not to the shell
+    signal(SIGINT, SIG_IGN);
+    signal(SIGQUIT, SIG_IGN);
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);
+
+    jobs_shell_pgid = getpid();
+    setpgid(0, jobs_shell_pgid);
+    tcsetpgrp(STDIN_FILENO, jobs_shell_pgid);
+    jobs_control = 1;
+}
+
+
+
+/**
+ * Signals and process group of a started command
+ * @param posix_spawnattr_t* attr - attributes of `posix_spawn`, destroyed by the caller
+ * @param pid_t pgid - process group of the job, 0 for a new group, -1 to stay in the group of the shell
+ * @return void - nothing
+ * */
+void jobs_spawn_attributes(posix_spawnattr_t *attr, pid_t pgid) {
+    sigset_t set;
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+
+    posix_spawnattr_init(attr);
+
+    // `SIGCHLD` is blocked while the job is started
+    sigemptyset(&set);
+    posix_spawnattr_setsigmask(attr, &set);
+
+    // Signals ignored by the interactive shell must work in the command
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGQUIT);
+    sigaddset(&set, SIGTSTP);
+    sigaddset(&set, SIGTTIN);
+    sigaddset(&set, SIGTTOU);
+    posix_spawnattr_setsigdefault(attr, &set);
+
+    if (jobs_control && pgid >= 0) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup(attr, pgid);
+    }
+
+    posix_spawnattr_setflags(attr, flags);
+}
+
+
+
+/**
+ * Signals and process group of a forked child, the same as `jobs_spawn_attributes`
+ * @param pid_t pgid - process group of the job, 0 for a new group, -1 to stay in the group of the shell
+ * @param int foreground - the job gets the terminal
+ * @return void - nothing
+ * */
+void jobs_child(pid_t pgid, int foreground) {
+    sigset_t set;
+
+    if (jobs_control && pgid >= 0) {
+        setpgid(0, pgid);
+    }
+
+    // `SIGTTOU` is still ignored here, so a new group can take the terminal
+    if (jobs_control && pgid == 0 && foreground) {
+        tcsetpgrp(STDIN_FILENO, getpid());
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGQUIT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    signal(SIGCHLD, SIG_DFL);
+
+    sigemptyset(&set);
+    sigprocmask(SIG_SETMASK, &set, NULL);
+}
+
+
+
+/**
+ * State of the whole job
+ * @param struct job* job - job
+ * @return enum job_state - running if any process runs, stopped if any is stopped, else done
+ * */
+enum job_state jobs_state(struct job *job) {
+    enum job_state state = JOB_DONE;
+    int i;
+
+    for (i = 0; i < job->count; i++) {
+        if (job->processes[i].state == JOB_RUNNING) {
+            return JOB_RUNNING;
+        }
+        if (job->processes[i].state == JOB_STOPPED) {
+            state = JOB_STOPPED;
+        }
+    }
+
+    return state;
+}
+
+
+
+/**
+ * Remove the job from the table
+ * @param struct job* job - job
+ * @return void - nothing
+ * */
+void jobs_remove(struct job *job) {
+    free(job->processes);
+    free(job->command);
+    job->id = 0;
+}
+
+
+
+/**
+ * Add the started pipeline to the table, `SIGCHLD` must be blocked since the processes are started
+ * @param pid_t* pids - started processes
+ * @param int count - number of processes
+ * @param char* command - command line, the table takes it
+ * @return struct job* job - added job or NULL if the table is full of unfinished jobs
+ * */
+struct job *jobs_add(pid_t *pids, int count, char *command) {
+    struct job *job = NULL;
+    int i;
+
+    for (i = 0; i < JOBS_MAX; i++) {
+        if (!jobs_table[i].id) {
+            job = &jobs_table[i];
+            break;
+        }
+    }
+
+    // Without a prompt nobody reports finished jobs, so they are dropped when the table is full
+    for (i = 0; !job && i < JOBS_MAX; i++) {
+        if (jobs_state(&jobs_table[i]) == JOB_DONE) {
+            jobs_remove(&jobs_table[i]);
+            job = &jobs_table[i];
+        }
+    }
+
+    if (!job) {
+        return NULL;
+    }
+
+    job->processes = malloc(count * sizeof(struct job_process));
+    if (!job->processes) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < count; i++) {
+        job->processes[i].pid = pids[i];
+        job->processes[i].state = JOB_RUNNING;
+    }
+
+    job->pgid = pids[0];
+    job->count = count;
+    job->command = command;
+    job->order = ++jobs_order;
+    memset(&job->usage, 0, sizeof(job->usage));
+    job->status = 0;
+    job->id = job - jobs_table + 1;
+
+    return job;
+}
+
+
+
+/**
+ * Find the job by `%n`, by pid or the current one
+ * @param char* spec - job number with `%`, process id, or NULL for the current job
+ * @return struct job* job - found job or NULL
+ * */
+struct job *jobs_find(char *spec) {
+    struct job *job = NULL;
+    pid_t pid;
+    int i, j;
+
+    for (i = 0; i < JOBS_MAX; i++) {
+        if (!jobs_table[i].id) {
+            continue;
+        }
+
+        if (spec == NULL || strcmp(spec, "%%") == 0 || strcmp(spec, "%+") == 0) {
+            if (!job || jobs_table[i].order > job->order) {
+                job = &jobs_table[i];
+            }
+        } else if (spec[0] == '%') {
+            if (jobs_table[i].id == atoi(spec + 1)) {
+                return &jobs_table[i];
+            }
+        } else {
+            pid = atoi(spec);
+            for (j = 0; j < jobs_table[i].count; j++) {
+                if (jobs_table[i].processes[j].pid == pid) {
+                    return &jobs_table[i];
+                }
+            }
+        }
+    }
+
+    return job;
+}
+
+
+
+/**
+ * Print the job in the format of bash
+ * @param struct job* job - job
+ * @return void - nothing
+ * */
+void jobs_print(struct job *job) {
+    static char *states[] = { "Running", "Stopped", "Done" };
+    enum job_state state = jobs_state(job);
+    char *label = states[state];
+    char exit_label[16];
+
+    // Failed job shows its exit code or the signal that killed it
+    if (state == JOB_DONE && WIFEXITED(job->status) && WEXITSTATUS(job->status) != 0) {
+        snprintf(exit_label, sizeof(exit_label), "Exit %d", WEXITSTATUS(job->status));
+        label = exit_label;
+    } else if (state == JOB_DONE && WIFSIGNALED(job->status)) {
+        label = strsignal(WTERMSIG(job->status));
+    }
+
+    printf("[%d]%c  %-24s%s%s\n", job->id, job == jobs_find(NULL) ? '+' : ' ', label,
+           job->command, state == JOB_RUNNING ? " &" : "");
+}
+
+
+
+/**
+ * Print finished background jobs and remove them, done before the prompt
+ * @param void - nothing on the input
+ * @return void - nothing
+ * */
+void jobs_notify(void) {
+    sigset_t old;
+    int i;
+
+    jobs_block(&old);
+    for (i = 0; i < JOBS_MAX; i++) {
+        if (jobs_table[i].id && jobs_state(&jobs_table[i]) == JOB_DONE) {
+            jobs_print(&jobs_table[i]);
+            jobs_remove(&jobs_table[i]);
+        }
+    }
+    jobs_unblock(&old);
+}
+
+
+
+/**
+ * Continue the stopped processes of the job
+ * @param struct job* job - job
+ * @return void - nothing
+ * */
+void jobs_continue(struct job *job) {
+    int i;
+
+    for (i = 0; i < job->count; i++) {
+        if (job->processes[i].state == JOB_STOPPED) {
+            job->processes[i].state = JOB_RUNNING;
+            if (!jobs_control) {
+                kill(job->processes[i].pid, SIGCONT);
+            }
+        }
+    }
+
+    if (jobs_control) {
+        kill(-job->pgid, SIGCONT);
+    }
+}
+
+
+
+/**
+ * Wait until the job is not running, `SIGCHLD` must be blocked
+ * @param struct job* job - job
+ * @param sigset_t* old - signal mask to wait with, it must not block `SIGCHLD`
+ * @return void - nothing
+ * */
+void jobs_wait(struct job *job, sigset_t *old) {
+    while (jobs_state(job) == JOB_RUNNING) {
+        sigsuspend(old);
+    }
+}
+
+
+
+/**
+ * Run the job in the foreground: give it the terminal and wait until it finishes or stops
+ * `SIGCHLD` must be blocked
+ * @param struct job* job - job
+ * @param sigset_t* old - signal mask to wait with, it must not block `SIGCHLD`
+ * @param struct rusage* usage - resources used by the finished processes of the job, may be NULL
+ * @return void - nothing
+ * */
+void jobs_foreground(struct job *job, sigset_t *old, struct rusage *usage) {
+    if (jobs_control) {
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+
+    jobs_wait(job, old);
+
+    if (jobs_control) {
+        tcsetpgrp(STDIN_FILENO, jobs_shell_pgid);
+    }
+
+    if (usage) {
+        *usage = job->usage;
+    }
+
+    // Stopped job stays in the table to be continued by `fg` or `bg`
+    if (jobs_state(job) == JOB_STOPPED) {
+        printf("\n");
+        jobs_print(job);
+    } else {
+        jobs_remove(job);
+    }
+}
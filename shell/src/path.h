@@ -0,0 +1,250 @@
+/**
+ * PATH
+ *
+ * This file contains the table of resolved command paths, the same as `hash` in bash
+ * A command is searched in the `$PATH` directories only the first time, after that it is started by its full path
+ * The table is cleared when `$PATH` changes, and a command is searched again if its file has vanished
+ * Commands found in relative directories of `$PATH`, empty or `.`, depend on the current directory and are not kept
+ * */
+
+
+
+#ifndef _STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+#ifndef _STRING_H
+#include <string.h>
+#endif
+
+
+#ifndef _SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+
+#ifndef _UNISTD_H
+#include <unistd.h>
+#endif
+
+
+
+#define PATH_TABLE_SIZE     64              /* Number of buckets in the table */
+
+
+
+/* Resolved command */
+struct path_entry {
+    char *name;                             /* Command name */
+    char *path;                             /* Full path of the executable */
+    unsigned hits;                          /* Number of times the command was started */
+    struct path_entry *next;                /* Next entry of the bucket */
+};
+
+
+
+/* Table of resolved commands and the `$PATH` it was filled with */
+struct path_entry *path_table[PATH_TABLE_SIZE];
+char *path_env = NULL;
+char *path_unhashed = NULL;                 /* Last command found in a relative directory, valid until the next lookup */
+
+
+
+/**
+ * Hash of the command name (FNV-1a)
+ * @param char* name - command name
+ * @return unsigned - bucket index
+ * */
+unsigned path_hash(char *name) {
+    unsigned hash = 2166136261u;
+
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+
+    return hash % PATH_TABLE_SIZE;
+}
+
+
+
+/**
+ * Forget all resolved commands
+ * @param void - nothing on the input
+ * @return void - nothing
+ * */
+void path_clear(void) {
+    struct path_entry *entry, *next;
+    int i;
+
+    for (i = 0; i < PATH_TABLE_SIZE; i++) {
+        for (entry = path_table[i]; entry != NULL; entry = next) {
+            next = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+        }
+        path_table[i] = NULL;
+    }
+}
+
+
+
+/**
+ * Forget one resolved command, e.g. when its file has vanished
+ * @param char* name - command name
+ * @return void - nothing
+ * */
+void path_forget(char *name) {
+    struct path_entry **link = &path_table[path_hash(name)];
+    struct path_entry *entry;
+
+    for (entry = *link; entry != NULL; link = &entry->next, entry = *link) {
+        if (strcmp(entry->name, name) == 0) {
+            *link = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+            return;
+        }
+    }
+}
+
+
+
+/**
+ * Search the command in the `$PATH` directories, as `execvp` does
+ * @param char* name - command name
+ * @param int* relative - set to 1 if the command is found in a relative directory, e.g. empty or `.`
+ * @return char* path - allocated full path or NULL if the command is not found
+ * */
+char *path_search(char *name, int *relative) {
+    size_t name_length = strlen(name);
+    char *dir = path_env;
+    char *path, *end;
+    size_t dir_length;
+    struct stat st;
+
+    while (dir != NULL) {
+        end = strchr(dir, ':');
+        dir_length = end ? (size_t)(end - dir) : strlen(dir);
+
+        // Empty directory is the current one
+        path = malloc(dir_length + name_length + 3);
+        if (!path) {
+            fprintf(stderr, "shell: allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+        if (dir_length == 0) {
+            path[0] = '.';
+            dir_length = 1;
+        } else {
+            memcpy(path, dir, dir_length);
+        }
+        path[dir_length] = '/';
+        memcpy(path + dir_length + 1, name, name_length + 1);
+
+        // Execute permission is checked for the user of the shell, not by the mode bits
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode) && access(path, X_OK) == 0) {
+            *relative = path[0] != '/';
+            return path;
+        }
+
+        free(path);
+        dir = end ? end + 1 : NULL;
+    }
+
+    return NULL;
+}
+
+
+
+/**
+ * Find the full path of the command, searching `$PATH` only if it is not resolved yet
+ * @param char* name - command name
+ * @return char* path - full path or NULL if the command is not found
+ * */
+char *path_lookup(char *name) {
+    char *env = getenv("PATH");
+    struct path_entry *entry;
+    unsigned hash;
+    char *path;
+    int relative;
+
+    // Names with a slash are paths themselves
+    if (strchr(name, '/')) {
+        return name;
+    }
+
+    // Commands of the old `$PATH` may be found elsewhere now
+    if (env == NULL) {
+        env = "/bin:/usr/bin";
+    }
+    if (path_env == NULL || strcmp(path_env, env) != 0) {
+        path_clear();
+        free(path_env);
+        path_env = strdup(env);
+        if (!path_env) {
+            fprintf(stderr, "shell: allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    hash = path_hash(name);
+    for (entry = path_table[hash]; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->name, name) == 0) {
+            entry->hits++;
+            return entry->path;
+        }
+    }
+
+    path = path_search(name, &relative);
+    if (!path) {
+        return NULL;
+    }
+
+    // The file depends on the current directory, so it is searched every time, as bash does
+    if (relative) {
+        free(path_unhashed);
+        path_unhashed = path;
+        return path;
+    }
+
+    entry = malloc(sizeof(struct path_entry));
+    if (!entry || !(entry->name = strdup(name))) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    entry->path = path;
+    entry->hits = 1;
+    entry->next = path_table[hash];
+    path_table[hash] = entry;
+
+    return path;
+}
+
+
+
+/**
+ * Print the resolved commands in the format of bash
+ * @param void - nothing on the input
+ * @return void - nothing
+ * */
+void path_print(void) {
+    struct path_entry *entry;
+    int i, empty = 1;
+
+    for (i = 0; i < PATH_TABLE_SIZE; i++) {
+        for (entry = path_table[i]; entry != NULL; entry = entry->next) {
+            if (empty) {
+                printf("hits\tcommand\n");
+                empty = 0;
+            }
+            printf("%4u\t%s\n", entry->hits, entry->path);
+        }
+    }
+
+    if (empty) {
+        printf("shell: hash table empty\n");
+    }
+}
@@ -0,0 +1,244 @@
+/**
+ * PROFILE
+ *
+ * This file contains the measurement of resources used by commands: `time` prints them for one command,
+ * and the profiling mode (`shell -p`) collects them for every command line and prints the slowest ones at exit
+ * Children resources come from `wait4`, builtins are measured with `getrusage` of the shell
+ * */
+
+
+
+#ifndef _STDIO_H
+#include <stdio.h>
+#endif
+
+
+#ifndef _STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+#ifndef _STRING_H
+#include <string.h>
+#endif
+
+
+#ifndef _SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+
+#ifndef _SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+
+
+#define PROFILE_TABLE_SIZE  1024            /* Number of buckets in the table of command lines */
+#define PROFILE_TOP         10              /* Number of command lines in the summary */
+
+
+
+/* Resources used by a command line */
+struct profile_usage {
+    double wall;                            /* Seconds */
+    struct rusage usage;                    /* Sum of all processes, `ru_maxrss` is the largest one */
+};
+
+
+/* Command line in the summary */
+struct profile_entry {
+    char *command;
+    unsigned long calls;
+    struct profile_usage total;
+    struct profile_entry *next;
+};
+
+
+
+/* Table of measured command lines */
+struct profile_entry *profile_table[PROFILE_TABLE_SIZE];
+unsigned long profile_entries = 0;
+int profile_enabled = 0;
+
+
+
+/**
+ * Seconds of the time value
+ * @param struct timeval* tv - time value
+ * @return double - seconds
+ * */
+double profile_seconds(struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+
+
+/**
+ * Add the resources of one process to the total
+ * @param struct rusage* total - sum, `ru_maxrss` is the maximum
+ * @param struct rusage* usage - resources of the process
+ * @return void - nothing
+ * */
+void profile_add(struct rusage *total, struct rusage *usage) {
+    timeradd(&total->ru_utime, &usage->ru_utime, &total->ru_utime);
+    timeradd(&total->ru_stime, &usage->ru_stime, &total->ru_stime);
+    total->ru_minflt += usage->ru_minflt;
+    total->ru_majflt += usage->ru_majflt;
+    total->ru_nvcsw += usage->ru_nvcsw;
+    total->ru_nivcsw += usage->ru_nivcsw;
+    if (usage->ru_maxrss > total->ru_maxrss) {
+        total->ru_maxrss = usage->ru_maxrss;
+    }
+}
+
+
+
+/**
+ * Resources used between two `getrusage` calls
+ * @param struct rusage* result - difference, `ru_maxrss` is the one of `after`
+ * @param struct rusage* after - later measurement
+ * @param struct rusage* before - earlier measurement
+ * @return void - nothing
+ * */
+void profile_subtract(struct rusage *result, struct rusage *after, struct rusage *before) {
+    timersub(&after->ru_utime, &before->ru_utime, &result->ru_utime);
+    timersub(&after->ru_stime, &before->ru_stime, &result->ru_stime);
+    result->ru_minflt = after->ru_minflt - before->ru_minflt;
+    result->ru_majflt = after->ru_majflt - before->ru_majflt;
+    result->ru_nvcsw = after->ru_nvcsw - before->ru_nvcsw;
+    result->ru_nivcsw = after->ru_nivcsw - before->ru_nivcsw;
+    result->ru_maxrss = after->ru_maxrss;
+}
+
+
+
+/**
+ * Print the resources used by the command, as `time` in bash with memory, switches and faults
+ * @param struct profile_usage* usage - measured resources
+ * @return void - nothing
+ * */
+void profile_print(struct profile_usage *usage) {
+    double user = profile_seconds(&usage->usage.ru_utime);
+    double sys = profile_seconds(&usage->usage.ru_stime);
+
+    // Report comes after the output of the command
+    fflush(stdout);
+    fprintf(stderr, "\nreal\t%dm%.3fs\n", (int)(usage->wall / 60), usage->wall - (int)(usage->wall / 60) * 60);
+    fprintf(stderr, "user\t%dm%.3fs\n", (int)(user / 60), user - (int)(user / 60) * 60);
+    fprintf(stderr, "sys\t%dm%.3fs\n", (int)(sys / 60), sys - (int)(sys / 60) * 60);
+    fprintf(stderr, "maxrss\t%ld KB\n", usage->usage.ru_maxrss);
+    fprintf(stderr, "csw\t%ld voluntary, %ld involuntary\n", usage->usage.ru_nvcsw, usage->usage.ru_nivcsw);
+    fprintf(stderr, "faults\t%ld minor, %ld major\n", usage->usage.ru_minflt, usage->usage.ru_majflt);
+}
+
+
+
+/**
+ * Add the measured command line to the table of the profiling mode
+ * @param char* command - command line
+ * @param struct profile_usage* usage - measured resources
+ * @return void - nothing
+ * */
+void profile_record(char *command, struct profile_usage *usage) {
+    struct profile_entry *entry;
+    unsigned hash = 2166136261u;
+    char *c;
+
+    for (c = command; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    hash %= PROFILE_TABLE_SIZE;
+
+    for (entry = profile_table[hash]; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->command, command) == 0) {
+            break;
+        }
+    }
+
+    if (!entry) {
+        entry = calloc(1, sizeof(struct profile_entry));
+        if (!entry || !(entry->command = strdup(command))) {
+            fprintf(stderr, "shell: allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+        entry->next = profile_table[hash];
+        profile_table[hash] = entry;
+        profile_entries++;
+    }
+
+    entry->calls++;
+    entry->total.wall += usage->wall;
+    profile_add(&entry->total.usage, &usage->usage);
+}
+
+
+
+/**
+ * Compare command lines by the total wall time, for `qsort`, the slowest first
+ * @param void* a - pointer to an entry
+ * @param void* b - pointer to an entry
+ * @return int - comparison result
+ * */
+int profile_compare(const void *a, const void *b) {
+    double wall_a = (*(struct profile_entry * const *)a)->total.wall;
+    double wall_b = (*(struct profile_entry * const *)b)->total.wall;
+
+    return (wall_a < wall_b) - (wall_a > wall_b);
+}
+
+
+
+/**
+ * Print the slowest command lines of the profiling mode and free the table
+ * @param void - nothing on the input
+ * @return void - nothing
+ * */
+void profile_summary(void) {
+    struct profile_entry **entries;
+    struct profile_entry *entry;
+    unsigned long count = 0, i;
+
+    if (!profile_enabled || profile_entries == 0) {
+        return;
+    }
+
+    entries = malloc(profile_entries * sizeof(struct profile_entry *));
+    if (!entries) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < PROFILE_TABLE_SIZE; i++) {
+        for (entry = profile_table[i]; entry != NULL; entry = entry->next) {
+            entries[count++] = entry;
+        }
+    }
+
+    qsort(entries, count, sizeof(struct profile_entry *), profile_compare);
+
+    fprintf(stderr, "\nshell: profile of %lu command lines, the slowest first\n", count);
+    fprintf(stderr, "%8s %10s %10s %10s %10s %8s %8s  %s\n",
+            "calls", "real", "user", "sys", "maxrss", "csw", "faults", "command");
+
+    for (i = 0; i < count && i < PROFILE_TOP; i++) {
+        entry = entries[i];
+        fprintf(stderr, "%8lu %9.3fs %9.3fs %9.3fs %8ldKB %8ld %8ld  %s\n",
+                entry->calls, entry->total.wall,
+                profile_seconds(&entry->total.usage.ru_utime),
+                profile_seconds(&entry->total.usage.ru_stime),
+                entry->total.usage.ru_maxrss,
+                entry->total.usage.ru_nvcsw + entry->total.usage.ru_nivcsw,
+                entry->total.usage.ru_minflt + entry->total.usage.ru_majflt,
+                entry->command);
+    }
+
+    for (i = 0; i < count; i++) {
+        free(entries[i]->command);
+        free(entries[i]);
+    }
+    for (i = 0; i < PROFILE_TABLE_SIZE; i++) {
+        profile_table[i] = NULL;
+    }
+    profile_entries = 0;
+    free(entries);
+}
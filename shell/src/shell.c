@@ -1,14 +1,25 @@
 /* Name: Shell implemetation */
 /* Author: Egor Bronnikov */
-/* Last edited: 2-03-2022 */
+/* Last edited: 19-10-2026 */
 
 
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <pwd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include "path.h"                           /* Resolved command paths */
+#include "profile.h"                        /* Resources used by commands */
+#include "jobs.h"                           /* Background jobs */
 #include "commands.h"                       /* Builtin functions */
 
 
@@ -16,14 +27,37 @@
 #define SHELL_RL_BUFSIZE    1024            /* Readline buffer size */
 #define SHELL_TOK_BUFSIZE   64              /* Token buffer size */
 #define SHELL_TOK_DELIM     " \t\r\n\a"     /* Token delimiter */
+#define SHELL_TOK_OPERATORS "|<>&"           /* Characters that end a word without a delimiter */
+#define SHELL_COMMENT       '#'             /* Word starting with it comments out the rest of the line */
+#define SHELL_BLOCK_SIZE    65536           /* Read size of scripts that can't be mapped */
 #define HOSTNAME_MAX        64              /* Hostname max size */
 
 
 
+/* Operator tokens, they are told apart from words by the address, not by the text */
+static char op_pipe[] = "|";
+static char op_input[] = "<";
+static char op_output[] = ">";
+static char op_append[] = ">>";
+static char op_background[] = "&";
+
+
+
+/* One stage of a pipeline: arguments and file redirections */
+struct command {
+    char **args;                            /* NULL terminated, points into the tokens array */
+    char *input;                            /* File for `<` or NULL */
+    char *output;                           /* File for `>` and `>>` or NULL */
+    int append;                             /* Output is `>>` */
+    pid_t pid;                              /* Started process */
+};
+
+
+
 /**
  * Read line from `stdin` and return this value
  * @param void - nothing on the input 
- * @return char* buffer - read string
+ * @return char* buffer - read string, NULL if there is nothing more to read
  */
 char *shell_readline(void) {
     int bufsize = SHELL_RL_BUFSIZE;
@@ -40,6 +74,12 @@ char *shell_readline(void) {
         // Read a character
         c = getchar();
         
+        // End of input without a line to execute
+        if (c == EOF && position == 0) {
+            free(buffer);
+            return NULL;
+        }
+
         // If we hit EOF, replace it with a null character and return
         if (c == EOF || c == '\n') {
             buffer[position] = '\0';
@@ -64,24 +104,64 @@ char *shell_readline(void) {
 
 
 /**
- * Splits the input string into separate tokens (command and arguments)
+ * Splits the input string into separate tokens (command, arguments and operators)
+ * Words stay in the line, they are only terminated with null characters
+ * The array is reused by the next line, so nothing is allocated per line
  * @param char* line - input line
  * @return char** tokens - array of tokens
  */
 char **shell_split_line(char *line) {
-    int bufsize = SHELL_TOK_BUFSIZE, position = 0;
-    char **tokens = malloc(bufsize * sizeof(char*));
+    static int bufsize = 0;
+    static char **tokens = NULL;
+    int position = 0;
     char *token;
+    char *c = line;
 
     if (!tokens) {
-        fprintf(stderr, "shell: allocation error\n");
-        exit(EXIT_FAILURE);
+        bufsize = SHELL_TOK_BUFSIZE;
+        tokens = malloc(bufsize * sizeof(char*));
+        if (!tokens) {
+            fprintf(stderr, "shell: allocation error\n");
+            exit(EXIT_FAILURE);
+        }
     }
 
-    token = strtok(line, SHELL_TOK_DELIM);
-    
-    // As long as we have tokens available, we write them into the array
-    while (token != NULL) {
+    while (1) {
+        // Skip delimiters
+        while (*c != '\0' && strchr(SHELL_TOK_DELIM, *c)) {
+            c++;
+        }
+        if (*c == '\0' || *c == SHELL_COMMENT) {
+            break;
+        }
+
+        // Operator also terminates the word before it, so it is overwritten
+        if (*c == '|') {
+            token = op_pipe;
+            *c++ = '\0';
+        } else if (*c == '<') {
+            token = op_input;
+            *c++ = '\0';
+        } else if (*c == '>' && c[1] == '>') {
+            token = op_append;
+            *c++ = '\0';
+            *c++ = '\0';
+        } else if (*c == '>') {
+            token = op_output;
+            *c++ = '\0';
+        } else if (*c == '&') {
+            token = op_background;
+            *c++ = '\0';
+        } else {
+            token = c;
+            while (*c != '\0' && !strchr(SHELL_TOK_DELIM SHELL_TOK_OPERATORS, *c)) {
+                c++;
+            }
+            if (*c != '\0' && strchr(SHELL_TOK_DELIM, *c)) {
+                *c++ = '\0';
+            }
+        }
+
         tokens[position] = token;
         position++;
 
@@ -94,8 +174,6 @@ char **shell_split_line(char *line) {
                 exit(EXIT_FAILURE);
             }
         }
-
-        token = strtok(NULL, SHELL_TOK_DELIM);
     }
     
     // End the array of tokens with NULL
@@ -107,31 +185,463 @@ char **shell_split_line(char *line) {
 
 
 /**
- * Run and execute proccess with all data saved in tokens array
- * @param char** tokens - array of tokens
+ * Checks if the token is an operator
+ * @param char* token - token
+ * @return int - 1 if the token is an operator else 0
+ */
+int shell_is_operator(char *token) {
+    return token == op_pipe || token == op_input || token == op_output || token == op_append ||
+           token == op_background;
+}
+
+
+
+/**
+ * Splits the tokens into pipeline stages, arguments are moved in place
+ * The array of stages is reused by the next line
+ * @param char** args - array of tokens, becomes arguments of all stages
+ * @param int* count - number of stages
+ * @param int* background - the pipeline ends with `&`
+ * @return struct command* commands - array of stages or NULL on syntax error
+ */
+struct command *shell_parse(char **args, int *count, int *background) {
+    static int bufsize = 0;
+    static struct command *commands = NULL;
+    int stages = 1, position = 0, i;
+    char *file;
+
+    for (i = 0; args[i] != NULL; i++) {
+        if (args[i] == op_pipe) {
+            stages++;
+        }
+    }
+
+    if (stages > bufsize) {
+        bufsize = stages;
+        commands = realloc(commands, bufsize * sizeof(struct command));
+        if (!commands) {
+            fprintf(stderr, "shell: allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    *count = 0;
+    *background = 0;
+    commands[0] = (struct command) { args, NULL, NULL, 0, -1 };
+
+    // Arguments never move right, so the array is rewritten while it is read
+    for (i = 0; args[i] != NULL; i++) {
+        struct command *command = &commands[*count];
+
+        if (args[i] == op_pipe) {
+            if (command->args == &args[position]) {
+                fprintf(stderr, "shell: syntax error near \"|\"\n");
+                return NULL;
+            }
+            args[position++] = NULL;
+            (*count)++;
+            commands[*count] = (struct command) { &args[position], NULL, NULL, 0, -1 };
+        } else if (args[i] == op_background) {
+            if (args[i + 1] != NULL) {
+                fprintf(stderr, "shell: syntax error near \"&\"\n");
+                return NULL;
+            }
+            *background = 1;
+        } else if (shell_is_operator(args[i])) {
+            file = args[i + 1];
+            if (file == NULL || shell_is_operator(file)) {
+                fprintf(stderr, "shell: syntax error near \"%s\"\n", args[i]);
+                return NULL;
+            }
+            if (args[i] == op_input) {
+                command->input = file;
+            } else {
+                command->output = file;
+                command->append = args[i] == op_append;
+            }
+            i++;
+        } else {
+            args[position++] = args[i];
+        }
+    }
+
+    if (commands[*count].args == &args[position]) {
+        fprintf(stderr, "shell: syntax error near \"%s\"\n", stages > 1 ? "|" : *background ? "&" : "newline");
+        return NULL;
+    }
+    args[position] = NULL;
+    (*count)++;
+
+    return commands;
+}
+
+
+
+/**
+ * Open the redirection files of the command as its standard input and output
+ * @param struct command* command - pipeline stage
+ * @return int - 0 on success or -1 if a file can't be opened
+ */
+int shell_redirect(struct command *command) {
+    int fd;
+
+    if (command->input) {
+        fd = open(command->input, O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || dup2(fd, STDIN_FILENO) < 0) {
+            fprintf(stderr, "shell: %s: %s\n", command->input, strerror(errno));
+            return -1;
+        }
+        close(fd);
+    }
+
+    if (command->output) {
+        fd = open(command->output, O_WRONLY | O_CREAT | O_CLOEXEC | (command->append ? O_APPEND : O_TRUNC), 0666);
+        if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+            fprintf(stderr, "shell: %s: %s\n", command->output, strerror(errno));
+            return -1;
+        }
+        close(fd);
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * Run the builtin command in the shell itself, redirections are undone after it
+ * @param struct command* command - single command
+ * @param int builtin - index of the builtin command
  * @return int status - this means that shell is running correct (1) or not (0)
- * If not, we are leaving from the loop
  */
-int shell_launch(char **args) {
-    pid_t pid, wpid;
-    int status;
+int shell_run_builtin(struct command *command, int builtin) {
+    int saved_input, saved_output;
+    int status = 1;
+
+    if (!command->input && !command->output) {
+        return (*builtin_func[builtin])(command->args);
+    }
 
-    pid = fork();
-    if (pid == 0) {
-        // Child process
-        if (execvp(args[0], args) == -1) {
+    saved_input = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+    saved_output = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+
+    // Output buffered before goes to the terminal, not to the redirection
+    fflush(stdout);
+
+    if (shell_redirect(command) == 0) {
+        status = (*builtin_func[builtin])(command->args);
+    }
+
+    // Output of the builtin goes to the redirection, not to the terminal
+    fflush(stdout);
+    dup2(saved_input, STDIN_FILENO);
+    dup2(saved_output, STDOUT_FILENO);
+    close(saved_input);
+    close(saved_output);
+
+    return status;
+}
+
+
+
+/**
+ * Run a file without a `#!` line as a script of `/bin/sh`, as `execvp` does
+ * `posix_spawn` reports such a file with `ENOEXEC` instead
+ * @param pid_t* pid - started process
+ * @param char* path - resolved file of the command
+ * @param posix_spawn_file_actions_t* actions - descriptors of the child
+ * @param posix_spawnattr_t* attr - process group and signals of the child
+ * @param char** args - arguments of the command
+ * @return int error - 0 on success or the error number
+ */
+static int shell_spawn_script(pid_t *pid, char *path, const posix_spawn_file_actions_t *actions,
+                              const posix_spawnattr_t *attr, char **args) {
+    size_t count = 0;
+    char **argv;
+    int error;
+
+    while (args[count]) {
+        count++;
+    }
+
+    // `/bin/sh path args[1] ... NULL`, the terminating NULL is copied with the arguments
+    argv = malloc((count + 2) * sizeof(char *));
+    if (!argv) {
+        return ENOMEM;
+    }
+    argv[0] = "/bin/sh";
+    argv[1] = path;
+    memcpy(argv + 2, args + 1, count * sizeof(char *));
+
+    error = posix_spawn(pid, "/bin/sh", actions, attr, argv, environ);
+    free(argv);
+    return error;
+}
+
+
+
+/**
+ * Start one stage of the pipeline
+ * External commands are started with `posix_spawn`, which does not copy the memory of the shell
+ * Builtins need the shell code, so they run in a forked child
+ * @param struct command* command - pipeline stage
+ * @param int input - read end of the previous pipe or -1
+ * @param int output - write end of the next pipe or -1
+ * @param pid_t pgid - process group of the job, 0 to start a new one
+ * @param int foreground - the job gets the terminal
+ * @return pid_t pid - started process or -1 on error
+ */
+pid_t shell_spawn(struct command *command, int input, int output, pid_t pgid, int foreground) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int builtin = shell_find_builtin(command->args[0]);
+    int redirect_input = -1, redirect_output = -1;
+    char *path;
+    int flags;
+    pid_t pid;
+    int error;
+
+    if (builtin >= 0) {
+        pid = fork();
+        if (pid == 0) {
+            jobs_child(pgid, foreground);
+            if ((input >= 0 && dup2(input, STDIN_FILENO) < 0) ||
+                (output >= 0 && dup2(output, STDOUT_FILENO) < 0) ||
+                shell_redirect(command) < 0) {
+                exit(EXIT_FAILURE);
+            }
+            (*builtin_func[builtin])(command->args);
+            fflush(stdout);
+            exit(EXIT_SUCCESS);
+        } else if (pid < 0) {
             perror("shell");
         }
+        return pid;
+    }
+
+    path = path_lookup(command->args[0]);
+    if (!path) {
+        fprintf(stderr, "shell: %s: command not found\n", command->args[0]);
+        return -1;
+    }
+
+    // Redirections are opened here rather than by the spawn, so a failure names the file
+    if (command->input) {
+        redirect_input = open(command->input, O_RDONLY | O_CLOEXEC);
+        if (redirect_input < 0) {
+            fprintf(stderr, "shell: %s: %s\n", command->input, strerror(errno));
+            return -1;
+        }
+    }
+    if (command->output) {
+        flags = O_WRONLY | O_CREAT | O_CLOEXEC | (command->append ? O_APPEND : O_TRUNC);
+        redirect_output = open(command->output, flags, 0666);
+        if (redirect_output < 0) {
+            fprintf(stderr, "shell: %s: %s\n", command->output, strerror(errno));
+            if (redirect_input >= 0) {
+                close(redirect_input);
+            }
+            return -1;
+        }
+    }
+
+    // Pipe ends and redirections are close-on-exec, so the copies made by `dup2` are the only ones left in the child
+    posix_spawn_file_actions_init(&actions);
+
+    // Leader of the foreground job takes the terminal before it can read it, the shell does it too
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 35)
+    if (jobs_control && pgid == 0 && foreground) {
+        posix_spawn_file_actions_addtcsetpgrp_np(&actions, STDIN_FILENO);
+    }
+#endif
+    if (input >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, input, STDIN_FILENO);
+    }
+    if (output >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO);
+    }
+    if (redirect_input >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, redirect_input, STDIN_FILENO);
+    }
+    if (redirect_output >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, redirect_output, STDOUT_FILENO);
+    }
+
+    jobs_spawn_attributes(&attr, pgid);
+    error = posix_spawn(&pid, path, &actions, &attr, command->args, environ);
+
+    // Resolved file has vanished, the command may be elsewhere in `$PATH` now.
+    // A script with a missing interpreter fails the same way, then the file is still there
+    if (error == ENOENT && path != command->args[0] && access(path, X_OK) < 0) {
+        path_forget(command->args[0]);
+        path = path_lookup(command->args[0]);
+        if (path) {
+            error = posix_spawn(&pid, path, &actions, &attr, command->args, environ);
+        }
+    }
+    if (error == ENOEXEC) {
+        error = shell_spawn_script(&pid, path, &actions, &attr, command->args);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (redirect_input >= 0) {
+        close(redirect_input);
+    }
+    if (redirect_output >= 0) {
+        close(redirect_output);
+    }
+
+    if (error) {
+        fprintf(stderr, "shell: %s: %s\n", command->args[0], strerror(error));
+        return -1;
+    }
+    return pid;
+}
+
+
+
+/**
+ * Make the command line of the pipeline to show in the list of jobs
+ * @param struct command* commands - pipeline stages
+ * @param int count - number of stages
+ * @return char* line - allocated command line
+ */
+char *shell_describe(struct command *commands, int count) {
+    size_t length = 1;
+    char *line;
+    char **arg;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        for (arg = commands[i].args; *arg != NULL; arg++) {
+            length += strlen(*arg) + 1;
+        }
+        length += commands[i].input ? strlen(commands[i].input) + 3 : 0;
+        length += commands[i].output ? strlen(commands[i].output) + 4 : 0;
+        length += 2;
+    }
+
+    line = malloc(length);
+    if (!line) {
+        fprintf(stderr, "shell: allocation error\n");
         exit(EXIT_FAILURE);
-    } else if (pid < 0) {
-        // Error forking
-        perror("shell");
+    }
+    line[0] = '\0';
+
+    for (i = 0; i < count; i++) {
+        if (i > 0) {
+            strcat(line, " | ");
+        }
+        for (arg = commands[i].args; *arg != NULL; arg++) {
+            if (arg != commands[i].args) {
+                strcat(line, " ");
+            }
+            strcat(line, *arg);
+        }
+        if (commands[i].input) {
+            strcat(line, " < ");
+            strcat(line, commands[i].input);
+        }
+        if (commands[i].output) {
+            strcat(line, commands[i].append ? " >> " : " > ");
+            strcat(line, commands[i].output);
+        }
+    }
+
+    return line;
+}
+
+
+
+/**
+ * Run the pipeline, every stage reads the output of the previous one
+ * The pipeline becomes a job, the shell waits for it unless it runs in the background
+ * @param struct command* commands - pipeline stages
+ * @param int count - number of stages
+ * @param int background - do not wait for the pipeline
+ * @param struct rusage* usage - resources used by the finished processes of the pipeline, may be NULL
+ * @return int status - this means that shell is running correct (1) or not (0)
+ * If not, we are leaving from the loop
+ */
+int shell_launch(struct command *commands, int count, int background, struct rusage *usage) {
+    struct rusage process;
+    struct job *job;
+    sigset_t old;
+    pid_t *pids;
+    int started = 0;
+    int input = -1;
+    int fds[2];
+    int i;
+
+    pids = malloc(count * sizeof(pid_t));
+    if (!pids) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Output of builtins must come before the output of the started commands
+    fflush(stdout);
+
+    // Background job without job control must not read the input of the shell
+    if (background && !jobs_control && !commands[0].input) {
+        input = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+
+    // Processes are reaped by the handler only after they are in the table
+    jobs_block(&old);
+
+    for (i = 0; i < count; i++) {
+        fds[0] = fds[1] = -1;
+        if (i < count - 1 && pipe2(fds, O_CLOEXEC) < 0) {
+            perror("shell");
+            break;
+        }
+
+        // The first process leads the process group of the job
+        commands[i].pid = shell_spawn(&commands[i], input, fds[1], started ? pids[0] : 0, !background);
+        if (commands[i].pid > 0) {
+            pids[started++] = commands[i].pid;
+            if (started == 1 && jobs_control && !background) {
+                tcsetpgrp(STDIN_FILENO, commands[i].pid);
+            }
+        }
+
+        // The shell keeps only the read end for the next stage
+        if (input >= 0) {
+            close(input);
+        }
+        if (fds[1] >= 0) {
+            close(fds[1]);
+        }
+        input = fds[0];
+    }
+
+    if (input >= 0) {
+        close(input);
+    }
+
+    job = started ? jobs_add(pids, started, shell_describe(commands, count)) : NULL;
+
+    if (!job) {
+        // Table is full: the pipeline is waited for without job control
+        if (started) {
+            fprintf(stderr, "shell: too many jobs\n");
+        }
+        while (!background && started-- > 0) {
+            if (wait4(pids[started], NULL, 0, &process) > 0 && usage) {
+                profile_add(usage, &process);
+            }
+        }
+    } else if (background) {
+        if (jobs_control) {
+            printf("[%d] %d\n", job->id, (int)job->processes[job->count - 1].pid);
+        }
     } else {
-        // Parent process
-        do {
-            wpid = waitpid(pid, &status, WUNTRACED);
-        } while (!WIFEXITED(status) && !WIFSIGNALED(status));
+        jobs_foreground(job, &old, usage);
     }
+
+    jobs_unblock(&old);
+    free(pids);
     return 1;
 }
 
@@ -139,26 +649,243 @@ int shell_launch(char **args) {
 
 /**
  * Select the commands that are built-in and those that are in the system
- * @param char** tokens - array of tokens
- * @see shell_launch(char **args)
+ * Resources used by a foreground command are measured if they are printed or profiled
+ * @param char** args - array of tokens
+ * @param int timed - print the used resources, the line started with `time`
+ * @see shell_launch(struct command *commands, int count, int background, struct rusage *usage)
  * @return status - command execution status
  */
-int shell_execute(char **args) {
-    int i;
+int shell_run(char **args, int timed) {
+    struct command *commands;
+    struct profile_usage usage;
+    struct rusage before, children, after, own;
+    struct timespec start, end;
+    char *line = NULL;
+    int count, builtin, background, status;
 
     if (args[0] == NULL) {
         // An empty command was entered
         return 1;
     }
 
-    // Try all of the builtin commands, and if one is found, execute
-    for (i = 0; i < shell_num_builtins(); i++) {
-        if(strcmp(args[0], builtin_str[i]) == 0) {
-            return (*builtin_func[i])(args);
+    commands = shell_parse(args, &count, &background);
+    if (!commands) {
+        return 1;
+    }
+
+    // Single builtin changes the shell itself, e.g. `cd` and `exit`
+    builtin = count == 1 && !background ? shell_find_builtin(commands[0].args[0]) : -1;
+
+    // Background job is neither printed nor profiled, the shell does not wait for it
+    if ((!timed && !profile_enabled) || background) {
+        return builtin >= 0 ? shell_run_builtin(&commands[0], builtin) : shell_launch(commands, count, background, NULL);
+    }
+
+    // Line is described before the command runs, `time` in a pipeline parses its own one
+    line = profile_enabled ? shell_describe(commands, count) : NULL;
+    memset(&usage, 0, sizeof(usage));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (builtin >= 0) {
+        // Builtin runs in the shell, children it waits for are counted too, e.g. of `parallel`
+        getrusage(RUSAGE_SELF, &before);
+        getrusage(RUSAGE_CHILDREN, &children);
+        status = shell_run_builtin(&commands[0], builtin);
+        getrusage(RUSAGE_CHILDREN, &after);
+        profile_subtract(&usage.usage, &after, &children);
+
+        // Children maximum covers all children ever waited for, it is theirs only if it has grown
+        if (after.ru_maxrss == children.ru_maxrss) {
+            usage.usage.ru_maxrss = 0;
         }
+
+        getrusage(RUSAGE_SELF, &after);
+        profile_subtract(&own, &after, &before);
+        profile_add(&usage.usage, &own);
+    } else {
+        status = shell_launch(commands, count, 0, &usage.usage);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    usage.wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (timed) {
+        profile_print(&usage);
+    }
+    if (line) {
+        profile_record(line, &usage);
+        free(line);
     }
 
-    return shell_launch(args);
+    return status;
+}
+
+
+
+/**
+ * Execute the command line, `time` before a pipeline measures all its stages
+ * @param char** args - array of tokens
+ * @see shell_run(char **args, int timed)
+ * @return status - command execution status
+ */
+int shell_execute(char **args) {
+    if (args[0] != NULL && strcmp(args[0], "time") == 0) {
+        return shell_run(args + 1, 1);
+    }
+
+    return shell_run(args, 0);
+}
+
+
+
+/**
+ * Execute all complete lines of the buffer, lines are tokenized in place
+ * @param char* buffer - script text, it is modified
+ * @param size_t length - text length
+ * @param size_t* consumed - number of bytes of executed lines
+ * @return int status - 0 if the shell must exit else 1
+ */
+int shell_run_lines(char *buffer, size_t length, size_t *consumed) {
+    char *line = buffer;
+    char *end = buffer + length;
+    char *newline;
+    int status = 1;
+
+    while (status && (newline = memchr(line, '\n', end - line)) != NULL) {
+        *newline = '\0';
+        status = shell_execute(shell_split_line(line));
+        line = newline + 1;
+    }
+
+    *consumed = line - buffer;
+    return status;
+}
+
+
+
+/**
+ * Execute the last line of the script that has no newline at the end
+ * @param char* line - line text, not null terminated
+ * @param size_t length - line length
+ * @return int status - 0 if the shell must exit else 1
+ */
+int shell_run_tail(char *line, size_t length) {
+    char *copy;
+    int status;
+
+    if (length == 0) {
+        return 1;
+    }
+
+    copy = malloc(length + 1);
+    if (!copy) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, line, length);
+    copy[length] = '\0';
+
+    status = shell_execute(shell_split_line(copy));
+    free(copy);
+    return status;
+}
+
+
+
+/**
+ * Execute the script read from the descriptor by big blocks, e.g. from a pipe
+ * @param int fd - file descriptor
+ * @return void - nothing
+ */
+void shell_run_stream(int fd) {
+    size_t bufsize = SHELL_BLOCK_SIZE, length = 0, consumed;
+    char *buffer = malloc(bufsize);
+    ssize_t n;
+    int status = 1;
+
+    if (!buffer) {
+        fprintf(stderr, "shell: allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while (status) {
+        // Line is longer than the buffer
+        if (length == bufsize) {
+            bufsize += SHELL_BLOCK_SIZE;
+            buffer = realloc(buffer, bufsize);
+            if (!buffer) {
+                fprintf(stderr, "shell: allocation error\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        n = read(fd, buffer + length, bufsize - length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            shell_run_tail(buffer, length);
+            break;
+        }
+        length += n;
+
+        // Incomplete line is moved to the beginning and completed by the next read
+        status = shell_run_lines(buffer, length, &consumed);
+        length -= consumed;
+        memmove(buffer, buffer + consumed, length);
+    }
+
+    free(buffer);
+}
+
+
+
+/**
+ * Execute the script file, regular files are mapped into memory instead of being read
+ * @param char* filename - script path
+ * @return int - EXIT_SUCCESS or EXIT_FAILURE if the script can't be opened
+ */
+int shell_run_script(char *filename) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    size_t consumed;
+    char *script;
+
+    if (fd < 0) {
+        fprintf(stderr, "shell: %s: %s\n", filename, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // Private writable mapping: lines are terminated in place and the file stays intact
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        (script = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)) != MAP_FAILED) {
+        close(fd);
+        madvise(script, st.st_size, MADV_SEQUENTIAL);
+        if (shell_run_lines(script, st.st_size, &consumed)) {
+            shell_run_tail(script + consumed, st.st_size - consumed);
+        }
+        munmap(script, st.st_size);
+        return EXIT_SUCCESS;
+    }
+
+    shell_run_stream(fd);
+    close(fd);
+    return EXIT_SUCCESS;
+}
+
+
+
+/**
+ * Execute the commands given with `-c`
+ * @param char* commands - command lines
+ * @return void - nothing
+ */
+void shell_run_string(char *commands) {
+    size_t consumed;
+
+    if (shell_run_lines(commands, strlen(commands), &consumed)) {
+        shell_run_tail(commands + consumed, strlen(commands + consumed));
+    }
 }
 
 
@@ -186,13 +913,17 @@ void shell_loop(void) {
     
     // Before we get out of the shell or encounter some terrible error, then keep reading new lines
     do {
+        jobs_notify();
         printf("\033[0;32m%s@%s\033[0;37m:~$ ", p->pw_name, hostname);
         line = shell_readline();
+        if (!line) {
+            printf("\n");
+            break;
+        }
         args = shell_split_line(line);
         status = shell_execute(args);
 
         free(line);
-        free(args);
     } while (status);
 }
 
@@ -200,11 +931,44 @@ void shell_loop(void) {
 
 /* Main function */
 int main(int argc, char **argv) {
-    // TODO: Load config files here
+    int status = EXIT_SUCCESS;
+    char *commands = NULL;
+    int opt;
+
+    // Options end at the script name, the rest are its arguments
+    while ((opt = getopt(argc, argv, "+c:p")) != -1) {
+        switch (opt) {
+            case 'c':
+                commands = optarg;
+                break;
+            case 'p':
+                profile_enabled = 1;
+                break;
+            default:
+                fprintf(stderr, "Usage: shell [-p] [-c commands | script]\n");
+                return EXIT_FAILURE;
+        }
+    }
 
-    // Run commands loop
-    shell_loop();
+    // Job control only for commands typed in a terminal
+    jobs_init(!commands && optind == argc && isatty(STDIN_FILENO));
+
+    if (commands) {
+        // shell -c "commands"
+        shell_run_string(commands);
+    } else if (optind < argc) {
+        // shell script.sh
+        status = shell_run_script(argv[optind]);
+    } else if (!isatty(STDIN_FILENO)) {
+        // Script from a pipe or a file: no prompt, no screen to clear
+        shell_run_stream(STDIN_FILENO);
+    } else {
+        // Run commands loop
+        shell_loop();
+    }
     
     // Shutdown and cleanup
-    return EXIT_SUCCESS;
+    fflush(stdout);
+    profile_summary();
+    return status;
 }
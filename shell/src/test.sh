@@ -0,0 +1,130 @@
+#!/bin/bash
+# Tests of the shell
+# Every test runs a script with the shell and compares its output with the expected one,
+# prints the name of every failed test and exits with 1 if there are any
+
+cd "$(dirname "$0")"
+make -s all
+
+script=$(mktemp)
+dir=$(mktemp -d)
+trap 'rm -rf "$script" "$dir"' EXIT
+
+failed=0
+
+# Usage: check NAME EXPECTED, the script is in "$script"
+check() {
+    local output
+    output=$(./shell "$script" 2>&1)
+    if [ "$output" != "$2" ]; then
+        echo "FAIL: $1"
+        diff <(echo "$2") <(echo "$output")
+        failed=1
+    fi
+}
+
+# Finished background jobs of a script are never reported, they must not fill the table
+for _ in $(seq 200); do
+    echo "true &"
+done > "$script"
+echo "echo after" >> "$script"
+check "more background jobs than the table holds" "after"
+
+# A file without `#!` is run by /bin/sh, as execvp() does
+printf 'echo script $1 $2\n' > "$dir/noshebang"
+chmod +x "$dir/noshebang"
+echo "$dir/noshebang a b" > "$script"
+check "script without #! line" "script a b"
+
+# A command found through `.` in $PATH depends on the current directory, it is not hashed
+mkdir "$dir/a" "$dir/b"
+printf 'echo in a\n' > "$dir/a/tool"
+printf 'echo in b\n' > "$dir/b/tool"
+chmod +x "$dir/a/tool" "$dir/b/tool"
+printf 'cd %s\ntool\ncd %s\ntool\nhash\n' "$dir/a" "$dir/b" > "$script"
+PATH=.:$PATH check "relative \$PATH entry" "in a
+in b
+shell: hash table empty"
+
+# Commands of parallel print their output and errors in the order of the inputs, whatever order they finish in
+printf '#!/bin/sh\nsleep "$1"\necho "out $1"\necho "err $1" >&2\nexit ${2:-0}\n' > "$dir/job"
+chmod +x "$dir/job"
+echo "parallel -j 3 $dir/job ::: 0.3 0.1 0.2" > "$script"
+check "parallel output order" "out 0.3
+err 0.3
+out 0.1
+err 0.1
+out 0.2
+err 0.2"
+
+echo "parallel -j 2 $dir/job 0 {} ::: 0 1 2" > "$script"
+check "parallel exit status" "out 0
+err 0
+out 0
+err 0
+out 0
+err 0
+shell: parallel: 2 of 3 commands failed"
+
+# Finished jobs keep the status of their last command, `wait` and `fg` return when the jobs finish
+printf '#!/bin/sh\nkill -TERM $$\n' > "$dir/die"
+chmod +x "$dir/die"
+cat > "$script" << END
+cd $dir
+./job 0.2 3 &
+./job 0.1 &
+./die &
+wait
+jobs
+jobs
+./job 0.2 &
+echo before
+fg
+echo after
+END
+check "wait and fg" "out 0.1
+err 0.1
+out 0.2
+err 0.2
+[1]   Exit 3                  ./job 0.2 3
+[2]   Done                    ./job 0.1
+[3]+  Terminated              ./die
+before
+./job 0.2
+out 0.2
+err 0.2
+after"
+
+# The file of a failed redirection is named, and the script goes on
+cat > "$script" << END
+cat < $dir/missing
+echo hi > $dir/missing/file
+help > $dir/missing/file
+echo still here
+END
+check "redirection errors" "shell: $dir/missing: No such file or directory
+shell: $dir/missing/file: No such file or directory
+shell: $dir/missing/file: No such file or directory
+still here"
+
+# A hashed command is searched again when its file is gone, `hash -r` forgets all of them
+mkdir "$dir/c"
+cp "$dir/a/tool" "$dir/c/tool"
+cat > "$script" << END
+tool
+hash
+$(command -v rm) $dir/c/tool
+tool
+hash
+hash -r
+hash
+END
+PATH=$dir/c:$dir/b:$PATH check "hash of a removed command" "in a
+hits	command
+   1	$dir/c/tool
+in b
+hits	command
+   1	$dir/b/tool
+shell: hash table empty"
+
+exit $failed
@@ -0,0 +1,76 @@
+#!/bin/bash
+# Benchmark of the web server over localhost
+# Sweeps backends, connection modes and connection counts, prints one JSON object per run
+#
+# Environment:
+#   BACKENDS     event loops to measure (default: "epoll uring")
+#   MODES        connection modes (default: "keep-alive close")
+#   CONNECTIONS  numbers of connections (default: "1 10 50 100 500")
+#   DURATION     seconds per run (default: 5)
+#   RATE         open-loop request rate, 0 for closed loop (default: 0)
+#   WORKERS      number of server workers (default: 1)
+#   PORT         server port (default: 5556)
+
+set -e
+
+BACKENDS=${BACKENDS:-"epoll uring"}
+MODES=${MODES:-"keep-alive close"}
+CONNECTIONS=${CONNECTIONS:-"1 10 50 100 500"}
+DURATION=${DURATION:-5}
+RATE=${RATE:-0}
+WORKERS=${WORKERS:-1}
+PORT=${PORT:-5556}
+
+cd "$(dirname "$0")"
+make -s all
+
+# Backend all workers of the running server report in /metrics, empty if they differ or some have not started
+running_backend() {
+    (exec 3<>/dev/tcp/127.0.0.1/"$PORT" && printf 'GET /metrics HTTP/1.0\r\n\r\n' >&3 && cat <&3) 2>/dev/null |
+        sed -n "s/^webserver_workers{backend=\"\(.*\)\"} $WORKERS\$/\1/p"
+}
+
+server_pid=
+trap '[ -n "$server_pid" ] && kill $server_pid 2>/dev/null' EXIT
+
+for backend in $BACKENDS; do
+    ./server -b "$backend" -w "$WORKERS" -p "$PORT" -l /dev/null > /dev/null &
+    server_pid=$!
+
+    # Wait until the server accepts connections
+    for _ in $(seq 50); do
+        (exec 3<>/dev/tcp/127.0.0.1/"$PORT") 2>/dev/null && break
+        sleep 0.1
+    done
+
+    # io_uring falls back to epoll when it is unavailable, results are labelled by what really runs
+    running=
+    for _ in $(seq 50); do
+        running=$(running_backend)
+        [ -n "$running" ] && break
+        sleep 0.1
+    done
+
+    if [ "$running" != "$backend" ]; then
+        echo "Error: the server runs ${running:-an unknown backend} instead of $backend, skipped" >&2
+        kill $server_pid
+        wait $server_pid 2>/dev/null || true
+        server_pid=
+        continue
+    fi
+
+    for mode in $MODES; do
+        flags=
+        [ "$mode" = "close" ] && flags=-C
+
+        for connections in $CONNECTIONS; do
+            echo "backend=$backend mode=$mode connections=$connections" >&2
+            ./loadgen -c "$connections" -d "$DURATION" -r "$RATE" -p "$PORT" -j $flags |
+                sed "s/^{/{\"backend\": \"$backend\", \"workers\": $WORKERS, /"
+        done
+    done
+
+    kill $server_pid
+    wait $server_pid 2>/dev/null || true
+    server_pid=
+done
@@ -0,0 +1,655 @@
+/* Name: Response cache for the web server */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "cache.h"
+
+
+#define HEADER_MAX  512                 /* Max length of the serialized headers */
+#define INDEX_FILE  "index.html"        /* File served for directories */
+#define WATCH_MASK  (IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_DELETE | \
+                     IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+
+/* Content types by file extension */
+static const struct content_type {
+    const char *extension;
+    const char *type;
+    int compressible;               /* Text formats worth compressing */
+} content_types[] = {
+    { ".html",  "text/html; charset=UTF-8",         1 },
+    { ".htm",   "text/html; charset=UTF-8",         1 },
+    { ".css",   "text/css; charset=UTF-8",          1 },
+    { ".js",    "text/javascript; charset=UTF-8",   1 },
+    { ".json",  "application/json",                 1 },
+    { ".txt",   "text/plain; charset=UTF-8",        1 },
+    { ".svg",   "image/svg+xml",                    1 },
+    { ".png",   "image/png",                        0 },
+    { ".jpg",   "image/jpeg",                       0 },
+    { ".jpeg",  "image/jpeg",                       0 },
+    { ".gif",   "image/gif",                        0 },
+    { ".ico",   "image/x-icon",                     0 }
+};
+
+static const struct content_type default_content_type = { "", "application/octet-stream", 0 };
+
+
+/**
+ *  Copy string into the new allocated memory
+ *  @param str      source string
+ *  @param length   number of bytes to copy
+ *  @return null-terminated copy of the string or NULL if there is no memory
+ */
+static char *cache_strndup(const char *str, size_t length)
+{
+    char *copy = malloc(length + 1);
+
+    if (copy) {
+        memcpy(copy, str, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+
+/**
+ *  Join the document root and the path relative to it
+ *  @param buffer   output buffer of `PATH_MAX` bytes
+ *  @param root     document root
+ *  @param path     relative path
+ *  @param length   relative path length
+ *  @return 0 on success or -1 if the result is too long
+ */
+static int cache_join(char *buffer, const char *root, const char *path, size_t length)
+{
+    size_t root_length = strlen(root);
+
+    if (root_length + length >= PATH_MAX) {
+        return -1;
+    }
+
+    memcpy(buffer, root, root_length);
+    memcpy(buffer + root_length, path, length);
+    buffer[root_length + length] = '\0';
+    return 0;
+}
+
+
+/**
+ *  FNV-1a hash of the request path
+ *  @param path     request path
+ *  @return bucket index
+ */
+static size_t cache_hash(const char *path)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*path) {
+        hash ^= (unsigned char)*path++;
+        hash *= 16777619u;
+    }
+
+    return hash % CACHE_BUCKETS;
+}
+
+
+/**
+ *  Find content type of the file by its extension
+ *  @param file     file path
+ *  @return content type
+ */
+static const struct content_type *cache_content_type(const char *file)
+{
+    const char *extension = strrchr(file, '.');
+    size_t i;
+
+    if (extension && !strchr(extension, '/')) {
+        for (i = 0; i < sizeof(content_types) / sizeof(content_types[0]); i++) {
+            if (strcasecmp(extension, content_types[i].extension) == 0) {
+                return &content_types[i];
+            }
+        }
+    }
+
+    return &default_content_type;
+}
+
+
+/**
+ *  Format time as an HTTP date
+ *  @param buffer   output buffer
+ *  @param size     output buffer size
+ *  @param time     time to format
+ *  @return number of written characters
+ */
+static size_t cache_http_date(char *buffer, size_t size, time_t time)
+{
+    struct tm tm;
+    gmtime_r(&time, &tm);
+    return strftime(buffer, size, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+
+/**
+ *  Watch the directory of the cached file for changes
+ *  @param cache    response cache
+ *  @param file     file path relative to the root
+ *  @return 0 if changes of the file are reported or -1 if it must not be cached
+ */
+static int cache_watch(struct cache *cache, const char *file)
+{
+    char dir[PATH_MAX];
+    size_t dir_length = strrchr(file, '/') - file;
+    struct cache_watch *watches;
+    size_t i;
+    int wd;
+
+    if (cache->inotify_fd < 0) {
+        return -1;
+    }
+
+    if (cache_join(dir, cache->root, file, dir_length) < 0) {
+        return -1;
+    }
+
+    wd = inotify_add_watch(cache->inotify_fd, dir, WATCH_MASK);
+    if (wd < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < cache->watch_count; i++) {
+        if (cache->watches[i].wd == wd) {
+            // The same directory under another name: it was moved since it was watched
+            if (strlen(cache->watches[i].dir) != dir_length ||
+                strncmp(cache->watches[i].dir, file, dir_length) != 0) {
+                char *renamed = cache_strndup(file, dir_length);
+                if (!renamed) {
+                    return -1;
+                }
+                free(cache->watches[i].dir);
+                cache->watches[i].dir = renamed;
+            }
+            return 0;
+        }
+    }
+
+    if (cache->watch_count == cache->watch_capacity) {
+        size_t capacity = cache->watch_capacity ? cache->watch_capacity * 2 : CACHE_WATCHES;
+        watches = realloc(cache->watches, capacity * sizeof(*watches));
+        if (!watches) {
+            inotify_rm_watch(cache->inotify_fd, wd);
+            return -1;
+        }
+        cache->watches = watches;
+        cache->watch_capacity = capacity;
+    }
+
+    cache->watches[cache->watch_count].dir = cache_strndup(file, dir_length);
+    if (!cache->watches[cache->watch_count].dir) {
+        inotify_rm_watch(cache->inotify_fd, wd);
+        return -1;
+    }
+    cache->watches[cache->watch_count].wd = wd;
+    cache->watch_count++;
+    return 0;
+}
+
+
+/**
+ *  Free the cache entry
+ *  @param entry    cache entry
+ */
+static void cache_entry_free(struct cache_entry *entry)
+{
+    int i;
+
+    for (i = 0; i < ENCODINGS; i++) {
+        free(entry->variants[i].header);
+        free(entry->variants[i].not_modified);
+        free(entry->variants[i].body);
+    }
+
+    if (entry->fd >= 0) {
+        close(entry->fd);
+    }
+
+    free(entry->path);
+    free(entry->file);
+    free(entry);
+}
+
+
+/**
+ *  Serialize headers of the variant
+ *  @param variant          variant with the body and the entity tag
+ *  @param encoding         content coding of the variant
+ *  @param type             content type of the file
+ *  @param last_modified    modification time of the file as an HTTP date
+ *  @return 0 on success or -1 if there is no memory
+ */
+static int cache_variant_headers(struct cache_variant *variant, enum encoding encoding,
+                                  const struct content_type *type, const char *last_modified)
+{
+    char buffer[HEADER_MAX];
+    char content_encoding[HEADER_MAX / 4] = "";
+    const char *vary = type->compressible ? "Vary: Accept-Encoding\r\n" : "";
+    int length;
+
+    if (encoding != ENCODING_IDENTITY) {
+        snprintf(content_encoding, sizeof(content_encoding),
+                 "Content-Encoding: %s\r\n", encoding_names[encoding]);
+    }
+
+    length = snprintf(buffer, sizeof(buffer),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Server: WebServer\r\n"
+                      "Content-Type: %s\r\n"
+                      "%s"
+                      "Content-Length: %zu\r\n"
+                      "%s"
+                      "Last-Modified: %s\r\n"
+                      "ETag: %s\r\n",
+                      type->type, content_encoding, variant->body_length,
+                      vary, last_modified, variant->etag);
+    variant->header = cache_strndup(buffer, length);
+    variant->header_length = length;
+
+    length = snprintf(buffer, sizeof(buffer),
+                      "HTTP/1.1 304 Not Modified\r\n"
+                      "Server: WebServer\r\n"
+                      "%s"
+                      "Last-Modified: %s\r\n"
+                      "ETag: %s\r\n",
+                      vary, last_modified, variant->etag);
+    variant->not_modified = cache_strndup(buffer, length);
+    variant->not_modified_length = length;
+
+    return variant->header && variant->not_modified ? 0 : -1;
+}
+
+
+/**
+ *  Read the file and serialize its response in every available coding
+ *  @param cache    response cache
+ *  @param path     request path
+ *  @param watched  set to 1 if changes of the file are reported, so the entry may be cached
+ *  @return new cache entry or NULL with `errno` ENOENT if there is no such file, ENOMEM if there is no memory
+ */
+static struct cache_entry *cache_load(struct cache *cache, const char *path, int *watched)
+{
+    char file[PATH_MAX];
+    char full_path[PATH_MAX];
+    char last_modified[DATE_MAX];
+    const struct content_type *type;
+    struct content_type streamed;
+    struct cache_entry *entry = NULL;
+    struct cache_variant *identity;
+    struct stat st;
+    size_t offset = 0;
+    int error = ENOENT;
+    int fd = -1;
+    int i;
+
+    snprintf(file, sizeof(file), "%s%s", path, path[strlen(path) - 1] == '/' ? INDEX_FILE : "");
+    if (cache_join(full_path, cache->root, file, strlen(file)) < 0) {
+        goto fail;
+    }
+
+    fd = open(full_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        goto fail;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        close(fd);
+        fd = -1;
+        strncat(file, "/" INDEX_FILE, sizeof(file) - strlen(file) - 1);
+        if (cache_join(full_path, cache->root, file, strlen(file)) < 0) {
+            goto fail;
+        }
+
+        fd = open(full_path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            goto fail;
+        }
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        goto fail;
+    }
+
+    // The watch goes first, so a change made while the file is read is reported
+    *watched = cache_watch(cache, file) == 0;
+    if (fstat(fd, &st) < 0) {
+        goto fail;
+    }
+
+    entry = malloc(sizeof(*entry));
+    if (!entry) {
+        error = ENOMEM;
+        goto fail;
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->fd = -1;
+    entry->refs = 1;
+
+    identity = &entry->variants[ENCODING_IDENTITY];
+    identity->body_length = st.st_size;
+    type = cache_content_type(file);
+
+    // A large file is sent from the disk by parts and is not kept, nor compressed
+    if (identity->body_length > CACHE_FILE_MAX) {
+        entry->fd = fd;
+        fd = -1;
+        streamed = *type;
+        streamed.compressible = 0;
+        type = &streamed;
+    } else {
+        identity->body = malloc(identity->body_length + 1);
+        if (!identity->body) {
+            error = ENOMEM;
+            goto fail;
+        }
+
+        while (offset < identity->body_length) {
+            ssize_t n = read(fd, identity->body + offset, identity->body_length - offset);
+            if (n <= 0) {
+                break;
+            }
+            offset += n;
+        }
+        identity->body_length = offset;
+        close(fd);
+        fd = -1;
+    }
+
+    cache_http_date(last_modified, sizeof(last_modified), st.st_mtime);
+
+    // Text is compressed here once, requests only pick the prebuilt variant
+    for (i = 0; i < ENCODINGS; i++) {
+        struct cache_variant *variant = &entry->variants[i];
+
+        if (i != ENCODING_IDENTITY &&
+            (!type->compressible || compress_body(i, identity->body, identity->body_length,
+                                                  &variant->body, &variant->body_length) < 0)) {
+            continue;
+        }
+
+        snprintf(variant->etag, sizeof(variant->etag), "\"%lx-%lx-%lx%s%s\"",
+                 (unsigned long)st.st_size, (unsigned long)st.st_mtim.tv_sec,
+                 (unsigned long)st.st_mtim.tv_nsec, i ? "-" : "", i ? encoding_names[i] : "");
+        if (cache_variant_headers(variant, i, type, last_modified) < 0) {
+            error = ENOMEM;
+            goto fail;
+        }
+    }
+
+    entry->path = cache_strndup(path, strlen(path));
+    entry->file = cache_strndup(file, strlen(file));
+    if (!entry->path || !entry->file) {
+        error = ENOMEM;
+        goto fail;
+    }
+
+    return entry;
+
+fail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (entry) {
+        cache_entry_free(entry);
+    }
+    errno = error;
+    return NULL;
+}
+
+
+/**
+ *  Drop one entry to make room for a new one, buckets are visited in turn
+ *  @param cache    response cache
+ */
+static void cache_evict(struct cache *cache)
+{
+    size_t i;
+
+    for (i = 0; i < CACHE_BUCKETS; i++) {
+        struct cache_entry **link = &cache->buckets[cache->evict_bucket];
+        cache->evict_bucket = (cache->evict_bucket + 1) % CACHE_BUCKETS;
+
+        if (*link) {
+            // The oldest entry of the bucket is at its end
+            while ((*link)->next) {
+                link = &(*link)->next;
+            }
+            cache_release(*link);
+            *link = NULL;
+            cache->entry_count--;
+            return;
+        }
+    }
+}
+
+
+/**
+ *  Initialize the response cache
+ *  @param cache    response cache
+ *  @param root     document root
+ */
+void cache_init(struct cache *cache, const char *root)
+{
+    memset(cache, 0, sizeof(*cache));
+    strncpy(cache->root, root, sizeof(cache->root) - 1);
+
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache->inotify_fd < 0) {
+        fprintf(stderr, "Error: Can't init inotify, files will not be cached\n");
+    }
+
+    cache_update_date(cache);
+}
+
+
+/**
+ *  Free all entries and close the inotify descriptor
+ *  @param cache    response cache
+ */
+void cache_free(struct cache *cache)
+{
+    size_t i;
+
+    cache_invalidate(cache, NULL);
+
+    for (i = 0; i < cache->watch_count; i++) {
+        free(cache->watches[i].dir);
+    }
+    free(cache->watches);
+    cache->watches = NULL;
+    cache->watch_count = 0;
+    cache->watch_capacity = 0;
+
+    if (cache->inotify_fd >= 0) {
+        close(cache->inotify_fd);
+        cache->inotify_fd = -1;
+    }
+}
+
+
+/**
+ *  Find the response for the request path, loading it on a miss
+ *  @param cache    response cache
+ *  @param path     request path, must start with '/'
+ *  @return referenced cache entry, release it with `cache_release()`, or NULL with `errno` set as `cache_load()` does
+ */
+struct cache_entry *cache_lookup(struct cache *cache, const char *path)
+{
+    size_t bucket = cache_hash(path);
+    struct cache_entry *entry;
+    int watched = 0;
+
+    for (entry = cache->buckets[bucket]; entry; entry = entry->next) {
+        if (strcmp(entry->path, path) == 0) {
+            entry->refs++;
+            return entry;
+        }
+    }
+
+    // Without a watch the file would never be invalidated, so it is served only once
+    entry = cache_load(cache, path, &watched);
+    if (entry && watched && entry->fd < 0) {
+        if (cache->entry_count == CACHE_ENTRIES) {
+            cache_evict(cache);
+        }
+        cache->entry_count++;
+        entry->refs++;
+        entry->next = cache->buckets[bucket];
+        cache->buckets[bucket] = entry;
+    }
+
+    return entry;
+}
+
+
+/**
+ *  Choose the smallest variant the client accepts
+ *  @param entry        cache entry
+ *  @param encodings    bit mask of accepted codings, `1 << encoding`
+ *  @return variant to send
+ */
+const struct cache_variant *cache_variant(const struct cache_entry *entry, unsigned encodings)
+{
+    const struct cache_variant *best = &entry->variants[ENCODING_IDENTITY];
+    int i;
+
+    for (i = ENCODING_IDENTITY + 1; i < ENCODINGS; i++) {
+        const struct cache_variant *variant = &entry->variants[i];
+        if ((encodings & (1u << i)) && variant->body && variant->body_length < best->body_length) {
+            best = variant;
+        }
+    }
+
+    return best;
+}
+
+
+/**
+ *  Drop the reference to the entry taken for an in-flight response
+ *  @param entry    cache entry
+ */
+void cache_release(struct cache_entry *entry)
+{
+    if (--entry->refs == 0) {
+        cache_entry_free(entry);
+    }
+}
+
+
+/**
+ *  Drop all entries served from the file
+ *  @param cache    response cache
+ *  @param file     file path relative to the root, NULL drops everything
+ */
+void cache_invalidate(struct cache *cache, const char *file)
+{
+    size_t i;
+
+    for (i = 0; i < CACHE_BUCKETS; i++) {
+        struct cache_entry **link = &cache->buckets[i];
+        while (*link) {
+            struct cache_entry *entry = *link;
+            if (!file || strcmp(entry->file, file) == 0) {
+                *link = entry->next;
+                cache_release(entry);
+                cache->entry_count--;
+            } else {
+                link = &entry->next;
+            }
+        }
+    }
+}
+
+
+/**
+ *  Read pending inotify events and invalidate changed files
+ *  @param cache    response cache
+ */
+void cache_process_events(struct cache *cache)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char file[PATH_MAX];
+    ssize_t length;
+
+    if (cache->inotify_fd < 0) {
+        return;
+    }
+
+    while ((length = read(cache->inotify_fd, buffer, sizeof(buffer))) > 0) {
+        char *ptr = buffer;
+
+        while (ptr < buffer + length) {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+            size_t i;
+
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                cache_invalidate(cache, NULL);
+                continue;
+            }
+
+            for (i = 0; i < cache->watch_count; i++) {
+                if (cache->watches[i].wd == event->wd) {
+                    break;
+                }
+            }
+
+            if (i == cache->watch_count) {
+                continue;
+            }
+
+            // The directory is gone or has another name: its watch is dropped and added again
+            // under the new name when a file from it is loaded
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                if (!(event->mask & IN_IGNORED)) {
+                    inotify_rm_watch(cache->inotify_fd, event->wd);
+                }
+                free(cache->watches[i].dir);
+                cache->watches[i] = cache->watches[--cache->watch_count];
+                cache_invalidate(cache, NULL);
+            } else if (event->len > 0) {
+                snprintf(file, sizeof(file), "%s/%s", cache->watches[i].dir, event->name);
+                cache_invalidate(cache, file);
+            }
+        }
+    }
+}
+
+
+/**
+ *  Refresh the `Date` header, at most once per second
+ *  @param cache    response cache
+ */
+void cache_update_date(struct cache *cache)
+{
+    time_t now = time(NULL);
+    char date[DATE_MAX];
+
+    if (now == cache->date_time) {
+        return;
+    }
+
+    cache->date_time = now;
+    cache_http_date(date, sizeof(date), now);
+    cache->date_length = snprintf(cache->date, DATE_MAX, "Date: %s\r\n", date);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+#include <limits.h>
+
+#include "compress.h"
+
+
+#define CACHE_BUCKETS   256         /* Number of hash table buckets */
+#define CACHE_WATCHES   64          /* Initial size of the table of watched directories */
+#define CACHE_ENTRIES   1024        /* Max number of cached responses */
+#define CACHE_FILE_MAX  (1 << 20)   /* Larger files are sent from the disk and not cached */
+#define ETAG_MAX        48          /* Max length of the `ETag` value */
+#define DATE_MAX        64          /* Max length of the `Date` header line */
+
+
+/* Serialized response in one content coding */
+struct cache_variant {
+    char *header;                   /* `200 OK` status line and headers, without `Date` */
+    size_t header_length;
+    char *not_modified;             /* `304 Not Modified` status line and headers, without `Date` */
+    size_t not_modified_length;
+    char *body;                     /* File contents, NULL if the variant is not available */
+    size_t body_length;
+    char etag[ETAG_MAX];            /* Quoted entity tag, unique for every coding */
+};
+
+
+/* Cached response: fully serialized headers and body of a single file */
+struct cache_entry {
+    char *path;                     /* Request path, the key */
+    char *file;                     /* Path of the file relative to the root */
+    struct cache_variant variants[ENCODINGS];
+    int fd;                         /* File sent by parts, its body is not in memory, or -1 */
+    int refs;                       /* References from the table and in-flight responses */
+    struct cache_entry *next;       /* Next entry in the bucket */
+};
+
+
+/* Watched directory */
+struct cache_watch {
+    int wd;                         /* inotify watch descriptor */
+    char *dir;                      /* Directory relative to the root */
+};
+
+
+struct cache {
+    char root[PATH_MAX];            /* Document root */
+    struct cache_entry *buckets[CACHE_BUCKETS];
+    size_t entry_count;
+    size_t evict_bucket;            /* Next bucket to evict from when the cache is full */
+    struct cache_watch *watches;    /* Grows as directories are watched */
+    size_t watch_count;
+    size_t watch_capacity;
+    int inotify_fd;                 /* Invalidation events, -1 if unavailable */
+    time_t date_time;               /* Time of the current `Date` header */
+    char date[DATE_MAX];            /* `Date` header line, copied into each response */
+    size_t date_length;
+};
+
+
+void cache_init(struct cache *cache, const char *root);
+void cache_free(struct cache *cache);
+struct cache_entry *cache_lookup(struct cache *cache, const char *path);
+const struct cache_variant *cache_variant(const struct cache_entry *entry, unsigned encodings);
+void cache_release(struct cache_entry *entry);
+void cache_invalidate(struct cache *cache, const char *file);
+void cache_process_events(struct cache *cache);
+void cache_update_date(struct cache *cache);
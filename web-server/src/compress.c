@@ -0,0 +1,248 @@
+/* Name: Compression of cached responses */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_BROTLI
+#include <setjmp.h>
+#include <brotli/encode.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compress.h"
+
+
+/* Names used in `Accept-Encoding` and `Content-Encoding` */
+const char *encoding_names[ENCODINGS] = {
+    "identity",
+    "gzip",
+    "br",
+    "zstd"
+};
+
+
+#ifdef HAVE_ZLIB
+/**
+ *  Compress into the gzip format with the best compression
+ *  @return 0 on success or -1 on failure
+ */
+static int compress_gzip(const char *input, size_t input_length, char *output, size_t *output_length)
+{
+    z_stream stream = { 0 };
+    int status;
+
+    // 15 bits window, +16 writes gzip header and trailer instead of zlib ones
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return -1;
+    }
+
+    stream.next_in = (Bytef *)input;
+    stream.avail_in = input_length;
+    stream.next_out = (Bytef *)output;
+    stream.avail_out = *output_length;
+
+    status = deflate(&stream, Z_FINISH);
+    *output_length = stream.total_out;
+    deflateEnd(&stream);
+
+    return status == Z_STREAM_END ? 0 : -1;
+}
+#endif
+
+
+#ifdef HAVE_BROTLI
+/* Block allocated by the brotli encoder, the header keeps the blocks of one encoder in a list */
+union brotli_block {
+    struct {
+        union brotli_block *next;
+        union brotli_block *prev;
+    } link;
+    long double align;
+};
+
+/* Memory of one brotli encoder. The encoder exits the process when an allocation fails,
+   so the allocator jumps back to `compress_brotli()` instead, and the blocks left are freed there */
+struct brotli_memory {
+    jmp_buf out_of_memory;
+    union brotli_block *blocks;
+};
+
+
+static void *brotli_alloc(void *opaque, size_t size)
+{
+    struct brotli_memory *memory = opaque;
+    union brotli_block *block = malloc(sizeof(*block) + size);
+
+    if (!block) {
+        longjmp(memory->out_of_memory, 1);
+    }
+
+    block->link.prev = NULL;
+    block->link.next = memory->blocks;
+    if (memory->blocks) {
+        memory->blocks->link.prev = block;
+    }
+    memory->blocks = block;
+
+    return block + 1;
+}
+
+
+static void brotli_free(void *opaque, void *address)
+{
+    struct brotli_memory *memory = opaque;
+    union brotli_block *block;
+
+    if (!address) {
+        return;
+    }
+
+    block = (union brotli_block *)address - 1;
+    if (block->link.prev) {
+        block->link.prev->link.next = block->link.next;
+    } else {
+        memory->blocks = block->link.next;
+    }
+    if (block->link.next) {
+        block->link.next->link.prev = block->link.prev;
+    }
+    free(block);
+}
+
+
+/**
+ *  Compress into the brotli format with the best compression
+ *  @return 0 on success or -1 on failure, also when the memory runs out
+ */
+static int compress_brotli(const char *input, size_t input_length, char *output, size_t *output_length)
+{
+    struct brotli_memory memory = { .blocks = NULL };
+    BrotliEncoderState *state;
+    const uint8_t *next_in = (const uint8_t *)input;
+    uint8_t *next_out = (uint8_t *)output;
+    size_t available_in = input_length;
+    size_t available_out = *output_length;
+    volatile int status = -1;
+
+    if (setjmp(memory.out_of_memory) == 0) {
+        state = BrotliEncoderCreateInstance(brotli_alloc, brotli_free, &memory);
+        if (state) {
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, BROTLI_MAX_QUALITY);
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN, BROTLI_DEFAULT_WINDOW);
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_SIZE_HINT, input_length);
+
+            // Without room for the whole output the encoder stops unfinished
+            if (BrotliEncoderCompressStream(state, BROTLI_OPERATION_FINISH, &available_in, &next_in,
+                                            &available_out, &next_out, NULL) &&
+                BrotliEncoderIsFinished(state)) {
+                *output_length -= available_out;
+                status = 0;
+            }
+            BrotliEncoderDestroyInstance(state);
+        }
+    }
+
+    // After a failed allocation the encoder state is left as it was
+    while (memory.blocks) {
+        brotli_free(&memory, memory.blocks + 1);
+    }
+
+    return status;
+}
+#endif
+
+
+/**
+ *  Check if the encoding was enabled at build time
+ *  @param encoding     content coding
+ *  @return 1 if the body can be compressed with it else 0
+ */
+int compress_available(enum encoding encoding)
+{
+    switch (encoding) {
+#ifdef HAVE_ZLIB
+        case ENCODING_GZIP: return 1;
+#endif
+#ifdef HAVE_BROTLI
+        case ENCODING_BROTLI: return 1;
+#endif
+#ifdef HAVE_ZSTD
+        case ENCODING_ZSTD: return 1;
+#endif
+        default: return 0;
+    }
+}
+
+
+/**
+ *  Compress the response body once, it is served from the cache afterwards
+ *  @param encoding         content coding
+ *  @param input            body
+ *  @param input_length     body length
+ *  @param output           allocated compressed body
+ *  @param output_length    compressed body length
+ *  @return 0 on success or -1 if the encoding is unavailable or does not make the body smaller
+ */
+int compress_body(enum encoding encoding, const char *input, size_t input_length,
+                  char **output, size_t *output_length)
+{
+    // Compressed body is useless if it is not smaller than the original one
+    size_t capacity = input_length;
+    int status = -1;
+    char *buffer;
+
+    // Without compressors built in the switch below is empty
+    (void)input;
+
+    if (!compress_available(encoding) || input_length == 0) {
+        return -1;
+    }
+
+    buffer = malloc(capacity);
+    if (!buffer) {
+        return -1;
+    }
+    *output_length = capacity;
+
+    switch (encoding) {
+#ifdef HAVE_ZLIB
+        case ENCODING_GZIP:
+            status = compress_gzip(input, input_length, buffer, output_length);
+            break;
+#endif
+#ifdef HAVE_BROTLI
+        case ENCODING_BROTLI:
+            status = compress_brotli(input, input_length, buffer, output_length);
+            break;
+#endif
+#ifdef HAVE_ZSTD
+        case ENCODING_ZSTD: {
+            size_t length = ZSTD_compress(buffer, capacity, input, input_length, ZSTD_maxCLevel());
+            status = ZSTD_isError(length) ? -1 : 0;
+            *output_length = length;
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+
+    if (status < 0 || *output_length >= input_length) {
+        free(buffer);
+        return -1;
+    }
+
+    *output = buffer;
+    return 0;
+}
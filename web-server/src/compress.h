@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+
+
+/* Content codings of cached responses, identity is always available */
+enum encoding {
+    ENCODING_IDENTITY,
+    ENCODING_GZIP,
+    ENCODING_BROTLI,
+    ENCODING_ZSTD,
+    ENCODINGS                       /* This necessary to get number of encodings */
+};
+
+
+extern const char *encoding_names[ENCODINGS];
+
+int compress_available(enum encoding encoding);
+int compress_body(enum encoding encoding, const char *input, size_t input_length,
+                  char **output, size_t *output_length);
@@ -0,0 +1,193 @@
+/* Name: epoll backend of the web server */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "server.h"
+
+
+#define EPOLL_EVENTS 256                /* Max number of events per `epoll_wait()` */
+
+
+/**
+ *  Close the connection and free its memory
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ */
+static void epoll_close(struct worker *worker, struct connection *conn)
+{
+    connection_end(worker, conn);
+    close(conn->fd);
+    free(conn);
+}
+
+
+/**
+ *  Accept all pending connections
+ *  @param worker   worker owning the listening socket
+ *  @param epfd     epoll file descriptor
+ *  @param spare_fd descriptor kept open to make room for a connection to drop when out of descriptors
+ */
+static void epoll_accept(struct worker *worker, int epfd, int *spare_fd)
+{
+    struct epoll_event event;
+    struct connection *conn;
+    int fd;
+
+    while (1) {
+        fd = accept4(worker->sockfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+
+            // The connection went away before it was accepted, the next one may be fine
+            if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) {
+                continue;
+            }
+
+            // The listener is level-triggered, so a connection left in the queue wakes the loop
+            // up again at once: free the spare descriptor to accept and drop it.
+            // `accept4()` fails this way even if the queue is empty, so stop when nothing is dropped
+            if ((errno == EMFILE || errno == ENFILE) && *spare_fd >= 0) {
+                close(*spare_fd);
+                fd = accept4(worker->sockfd, NULL, NULL, SOCK_CLOEXEC);
+                if (fd >= 0) {
+                    close(fd);
+                }
+                *spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+                fprintf(stderr, "Error: Out of file descriptors, connection dropped\n");
+                continue;
+            }
+
+            fprintf(stderr, "Error: Can't accept connection: %s\n", strerror(errno));
+            return;
+        }
+
+        conn = malloc(sizeof(*conn));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        connection_init(worker, conn, fd);
+
+        // Edge-triggered: the connection is driven until `EAGAIN` on every event
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = conn;
+
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            epoll_close(worker, conn);
+        }
+    }
+}
+
+
+/**
+ *  Read requests and write responses until the socket would block
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ */
+static void epoll_serve(struct worker *worker, struct connection *conn)
+{
+    ssize_t n;
+
+    while (1) {
+        if (conn->iovcnt > 0) {
+            n = writev(conn->fd, conn->iov + conn->iov_index, conn->iovcnt);
+            if (n < 0) {
+                if (errno != EAGAIN) {
+                    epoll_close(worker, conn);
+                }
+                return;
+            }
+
+            if (!connection_sent(worker, conn, n)) {
+                continue;
+            }
+
+            if (!connection_next(conn)) {
+                epoll_close(worker, conn);
+                return;
+            }
+
+            // Pipelined request may already be in the buffer
+            connection_process(worker, conn);
+            continue;
+        }
+
+        n = read(conn->fd, conn->buffer + conn->length, CONNECTION_BUFSIZE - conn->length);
+        if (n == 0 || (n < 0 && errno != EAGAIN)) {
+            epoll_close(worker, conn);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+
+        connection_received(worker, conn, n);
+        connection_process(worker, conn);
+    }
+}
+
+
+/**
+ *  Serve connections with readiness notifications
+ *  @param worker   worker to run
+ */
+void epoll_loop(struct worker *worker)
+{
+    struct epoll_event events[EPOLL_EVENTS];
+    struct epoll_event event;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    int spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    int i, n;
+
+    if (epfd < 0) {
+        fprintf(stderr, "Error: Can't create epoll instance\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // The listening socket and inotify are told apart by the address of their descriptors
+    event.events = EPOLLIN;
+    event.data.ptr = &worker->sockfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, worker->sockfd, &event);
+
+    if (worker->cache.inotify_fd >= 0) {
+        event.events = EPOLLIN;
+        event.data.ptr = &worker->cache.inotify_fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, worker->cache.inotify_fd, &event);
+    }
+
+    worker_started(worker, BACKEND_EPOLL);
+
+    while (1) {
+        n = epoll_wait(epfd, events, EPOLL_EVENTS, -1);
+
+        for (i = 0; i < n; i++) {
+            if (events[i].data.ptr == &worker->sockfd) {
+                epoll_accept(worker, epfd, &spare_fd);
+            } else if (events[i].data.ptr == &worker->cache.inotify_fd) {
+                cache_process_events(&worker->cache);
+            } else {
+                epoll_serve(worker, events[i].data.ptr);
+            }
+        }
+    }
+
+    close(spare_fd);
+    close(epfd);
+}
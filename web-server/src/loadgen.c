@@ -0,0 +1,609 @@
+/* Name: HTTP load generator for the web server */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+
+#define PORT            5555
+#define ADDRESS         "127.0.0.1"
+#define CONNECTIONS_MAX 65536
+#define EPOLL_EVENTS    256
+#define CLIENT_BUFSIZE  8192
+#define REQUEST_MAX     1024
+
+#define HIST_SUB_BITS   7                       /* Precision of histogram: 2^7 buckets per power of two */
+#define HIST_SUB        (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS    ((64 - HIST_SUB_BITS) * HIST_SUB)
+
+#define NSEC            1000000000ull
+
+
+enum client_state {
+    CLIENT_IDLE,                /* Waiting for the next request to be scheduled */
+    CLIENT_WRITING,             /* Writes wait with `EAGAIN` while the socket is connecting */
+    CLIENT_READING
+};
+
+
+/* One connection of the load generator */
+struct client {
+    int fd;                     /* Socket or -1 if not connected */
+    enum client_state state;
+    uint64_t start;             /* Intended send time of the current request */
+    uint64_t next;              /* Scheduled time of the next request in open-loop mode */
+    size_t sent;                /* Sent bytes of the request */
+    size_t length;              /* Received bytes of the response headers */
+    long body_left;             /* Body bytes to receive, -1 reads until the server closes */
+    int headers_done;
+    int server_close;           /* Server closes the connection after the response */
+    char buffer[CLIENT_BUFSIZE];
+};
+
+
+/* Log-linear latency histogram in nanoseconds, relative error is below 1% */
+struct histogram {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+};
+
+
+/* Run settings and results */
+struct loadgen {
+    struct sockaddr_in address;
+    int connections;
+    int keep_alive;
+    double rate;                /* Requests per second for all connections, 0 for closed loop */
+    double duration;
+    char request[REQUEST_MAX];
+    size_t request_length;
+    uint64_t interval;          /* Time between requests of one connection in open-loop mode */
+    uint64_t wake;              /* Earliest time an idle connection has to be started */
+    int epfd;
+    struct client *clients;
+    struct histogram histogram;
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+};
+
+
+/**
+ *  Monotonic time
+ *  @return time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC + ts.tv_nsec;
+}
+
+
+/**
+ *  Bucket of the value: exact below `HIST_SUB`, then `HIST_SUB` buckets per power of two
+ *  @param value    latency in nanoseconds
+ *  @return bucket index
+ */
+static int histogram_index(uint64_t value)
+{
+    int msb, shift;
+
+    if (value < HIST_SUB) {
+        return value;
+    }
+
+    msb = 63 - __builtin_clzll(value);
+    shift = msb - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB + (int)((value >> shift) - HIST_SUB);
+}
+
+
+/**
+ *  Highest value of the bucket
+ *  @param index    bucket index
+ *  @return latency in nanoseconds
+ */
+static uint64_t histogram_value(int index)
+{
+    int shift;
+
+    if (index < HIST_SUB) {
+        return index;
+    }
+
+    shift = index / HIST_SUB - 1;
+    return (((uint64_t)(index % HIST_SUB + HIST_SUB) + 1) << shift) - 1;
+}
+
+
+static void histogram_record(struct histogram *histogram, uint64_t value)
+{
+    histogram->counts[histogram_index(value)]++;
+    histogram->total++;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+
+/**
+ *  Value below which the given fraction of samples falls
+ *  @param histogram    latency histogram
+ *  @param quantile     fraction from 0 to 1
+ *  @return latency in nanoseconds
+ */
+static uint64_t histogram_quantile(const struct histogram *histogram, double quantile)
+{
+    uint64_t rank = (uint64_t)(quantile * histogram->total + 0.5);
+    uint64_t seen = 0;
+    int i;
+
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t value = histogram_value(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+
+/**
+ *  Close the connection, the next request opens a new one
+ *  @param client   connection
+ */
+static void client_close(struct client *client)
+{
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    client->state = CLIENT_IDLE;
+}
+
+
+/**
+ *  Start the request, connecting first if needed
+ *  @param lg       load generator
+ *  @param client   connection
+ *  @param start    intended send time used for the latency
+ */
+static void client_start(struct loadgen *lg, struct client *client, uint64_t start)
+{
+    struct epoll_event event;
+    int enable = 1;
+
+    client->start = start;
+    client->sent = 0;
+    client->length = 0;
+    client->body_left = 0;
+    client->headers_done = 0;
+    client->server_close = 0;
+
+    if (client->fd >= 0) {
+        client->state = CLIENT_WRITING;
+        return;
+    }
+
+    client->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (client->fd < 0) {
+        lg->errors++;
+        client->state = CLIENT_IDLE;
+        return;
+    }
+
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    if (connect(client->fd, (struct sockaddr *)&lg->address, sizeof(lg->address)) < 0 &&
+        errno != EINPROGRESS) {
+        lg->errors++;
+        client_close(client);
+        return;
+    }
+
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = client;
+    epoll_ctl(lg->epfd, EPOLL_CTL_ADD, client->fd, &event);
+
+    client->state = CLIENT_WRITING;
+}
+
+
+/**
+ *  Parse the status line and the headers of the response
+ *  @param lg       load generator
+ *  @param client   connection
+ *  @return number of header bytes, 0 if incomplete, -1 if malformed
+ */
+static long client_parse_headers(struct loadgen *lg, struct client *client)
+{
+    char *end, *line, *line_end;
+    int status;
+
+    client->buffer[client->length] = '\0';
+    end = strstr(client->buffer, "\r\n\r\n");
+    if (!end) {
+        return client->length == CLIENT_BUFSIZE - 1 ? -1 : 0;
+    }
+    end += 4;
+
+    if (sscanf(client->buffer, "HTTP/1.%*d %d", &status) != 1) {
+        return -1;
+    }
+
+    if (status >= 400) {
+        lg->errors++;
+    }
+
+    // Responses without body, otherwise read until the server closes if the length is unknown
+    client->body_left = (status == 204 || status == 304 || status < 200) ? 0 : -1;
+    client->server_close = 0;
+
+    for (line = strstr(client->buffer, "\r\n") + 2; line < end - 2; line = line_end + 2) {
+        line_end = strstr(line, "\r\n");
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0 && client->body_left != 0) {
+            client->body_left = strtol(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char *value = line + 11;
+            while (*value == ' ') value++;
+            client->server_close = strncasecmp(value, "close", 5) == 0;
+        }
+    }
+
+    if (client->body_left < 0) {
+        client->server_close = 1;
+    }
+
+    client->headers_done = 1;
+    return end - client->buffer;
+}
+
+
+/**
+ *  Account the finished request and schedule the next one
+ *  @param lg       load generator
+ *  @param client   connection
+ *  @param now      current time
+ */
+static void client_done(struct loadgen *lg, struct client *client, uint64_t now)
+{
+    lg->requests++;
+    histogram_record(&lg->histogram, now - client->start);
+
+    if (!lg->keep_alive || client->server_close) {
+        client_close(client);
+    }
+    client->state = CLIENT_IDLE;
+
+    if (lg->rate == 0) {
+        client_start(lg, client, now);
+    } else if (client->next <= now) {
+        // Late request: its latency includes the time it waited to be sent
+        client_start(lg, client, client->next);
+        client->next += lg->interval;
+    } else if (client->next < lg->wake) {
+        lg->wake = client->next;
+    }
+}
+
+
+/**
+ *  Drive the connection until the socket would block
+ *  @param lg       load generator
+ *  @param client   connection
+ */
+static void client_drive(struct loadgen *lg, struct client *client)
+{
+    char discard[CLIENT_BUFSIZE];
+    ssize_t n;
+
+    while (1) {
+        switch (client->state) {
+            case CLIENT_IDLE:
+                return;
+
+            case CLIENT_WRITING:
+                n = write(client->fd, lg->request + client->sent, lg->request_length - client->sent);
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == ENOTCONN) {
+                        return;
+                    }
+                    lg->errors++;
+                    client_close(client);
+                    return;
+                }
+                lg->bytes_out += n;
+                client->sent += n;
+                if (client->sent == lg->request_length) {
+                    client->state = CLIENT_READING;
+                }
+                break;
+
+            case CLIENT_READING:
+                if (!client->headers_done) {
+                    n = read(client->fd, client->buffer + client->length,
+                             CLIENT_BUFSIZE - 1 - client->length);
+                } else {
+                    size_t want = sizeof(discard);
+                    if (client->body_left > 0 && (size_t)client->body_left < want) {
+                        want = client->body_left;
+                    }
+                    n = read(client->fd, discard, want);
+                }
+
+                if (n < 0) {
+                    if (errno == EAGAIN) {
+                        return;
+                    }
+                    lg->errors++;
+                    client_close(client);
+                    return;
+                }
+
+                if (n == 0) {
+                    // Closed by the server: complete only if the body is delimited by close
+                    client_close(client);
+                    if (client->headers_done && client->body_left < 0) {
+                        client_done(lg, client, now_ns());
+                    } else {
+                        lg->errors++;
+                    }
+                    break;
+                }
+
+                lg->bytes_in += n;
+
+                if (!client->headers_done) {
+                    long header_length;
+
+                    client->length += n;
+                    header_length = client_parse_headers(lg, client);
+                    if (header_length < 0) {
+                        lg->errors++;
+                        client_close(client);
+                        return;
+                    }
+                    if (header_length == 0) {
+                        break;
+                    }
+                    n = client->length - header_length;
+                }
+
+                if (client->body_left > 0) {
+                    client->body_left -= n;
+                }
+
+                if (client->body_left == 0) {
+                    client_done(lg, client, now_ns());
+                }
+                break;
+        }
+    }
+}
+
+
+/**
+ *  Run the load for the configured duration
+ *  @param lg       load generator
+ *  @return actual duration in seconds
+ */
+static double loadgen_run(struct loadgen *lg)
+{
+    struct epoll_event events[EPOLL_EVENTS];
+    uint64_t start = now_ns();
+    uint64_t end = start + (uint64_t)(lg->duration * NSEC);
+    uint64_t now = start;
+    struct timespec timeout;
+    int i, n;
+
+    // Open-loop schedules of the connections are spread evenly over one interval
+    for (i = 0; i < lg->connections; i++) {
+        struct client *client = &lg->clients[i];
+        client->fd = -1;
+        client->state = CLIENT_IDLE;
+        client->next = start + (lg->rate ? lg->interval * i / lg->connections : 0);
+    }
+
+    lg->wake = start;
+
+    while (now < end) {
+        // Start due open-loop requests, closed-loop connections that failed are retried every millisecond
+        if (now >= lg->wake) {
+            lg->wake = lg->rate ? end : now + NSEC / 1000;
+
+            for (i = 0; i < lg->connections; i++) {
+                struct client *client = &lg->clients[i];
+
+                if (client->state != CLIENT_IDLE) {
+                    continue;
+                }
+
+                if (lg->rate == 0) {
+                    client_start(lg, client, now);
+                } else if (client->next <= now) {
+                    client_start(lg, client, client->next);
+                    client->next += lg->interval;
+                } else {
+                    if (client->next < lg->wake) {
+                        lg->wake = client->next;
+                    }
+                    continue;
+                }
+
+                client_drive(lg, client);
+            }
+        }
+
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = lg->wake > now ? lg->wake - now : 0;
+        if (timeout.tv_nsec > (long)(NSEC / 10)) {
+            timeout.tv_nsec = NSEC / 10;
+        }
+
+        n = epoll_pwait2(lg->epfd, events, EPOLL_EVENTS, &timeout, NULL);
+
+        for (i = 0; i < n; i++) {
+            client_drive(lg, events[i].data.ptr);
+        }
+
+        now = now_ns();
+    }
+
+    for (i = 0; i < lg->connections; i++) {
+        client_close(&lg->clients[i]);
+    }
+
+    return (double)(now - start) / NSEC;
+}
+
+
+/**
+ *  Print results as text or as a single JSON object
+ *  @param lg       load generator
+ *  @param elapsed  actual duration in seconds
+ *  @param json     print JSON
+ */
+static void loadgen_report(const struct loadgen *lg, double elapsed, int json)
+{
+    const struct histogram *h = &lg->histogram;
+    double rps = lg->requests / elapsed;
+    double p50 = histogram_quantile(h, 0.50) / 1e3;
+    double p99 = histogram_quantile(h, 0.99) / 1e3;
+    double p999 = histogram_quantile(h, 0.999) / 1e3;
+    double max = h->max / 1e3;
+
+    if (json) {
+        printf("{\"connections\": %d, \"mode\": \"%s\", \"rate\": %.0f, \"duration\": %.3f, "
+               "\"requests\": %llu, \"rps\": %.1f, \"errors\": %llu, "
+               "\"bytes_in\": %llu, \"bytes_out\": %llu, "
+               "\"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f, \"max_us\": %.1f}\n",
+               lg->connections, lg->keep_alive ? "keep-alive" : "close", lg->rate, elapsed,
+               (unsigned long long)lg->requests, rps, (unsigned long long)lg->errors,
+               (unsigned long long)lg->bytes_in, (unsigned long long)lg->bytes_out,
+               p50, p99, p999, max);
+        return;
+    }
+
+    printf("Connections: %d, %s, ", lg->connections, lg->keep_alive ? "keep-alive" : "close");
+    if (lg->rate) {
+        printf("open loop at %.0f req/s\n", lg->rate);
+    } else {
+        printf("closed loop\n");
+    }
+    printf("Requests:    %llu in %.2f s, %.1f req/s\n", (unsigned long long)lg->requests, elapsed, rps);
+    printf("Errors:      %llu\n", (unsigned long long)lg->errors);
+    printf("Transfer:    %.2f MB in, %.2f MB out\n", lg->bytes_in / 1e6, lg->bytes_out / 1e6);
+    printf("Latency:     p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", p50, p99, p999, max);
+}
+
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: loadgen [-c connections] [-d seconds] [-r rate] [-C] [-j]\n"
+                    "               [-a address] [-p port] [-u path] [-H header]\n"
+                    "  -c  number of connections (default 10)\n"
+                    "  -d  duration in seconds (default 10)\n"
+                    "  -r  open-loop request rate for all connections, 0 for closed loop (default 0)\n"
+                    "  -C  close the connection after every request instead of keep-alive\n"
+                    "  -j  print results as JSON\n"
+                    "  -H  extra request header, e.g. \"Accept-Encoding: gzip\"\n");
+    exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char **argv)
+{
+    static struct loadgen lg;
+    const char *address = ADDRESS;
+    const char *path = "/";
+    const char *header = NULL;
+    int port = PORT;
+    int json = 0;
+    int opt;
+    double elapsed;
+
+    lg.connections = 10;
+    lg.duration = 10;
+    lg.keep_alive = 1;
+
+    while ((opt = getopt(argc, argv, "c:d:r:Cja:p:u:H:")) != -1) {
+        switch (opt) {
+            case 'c': lg.connections = atoi(optarg); break;
+            case 'd': lg.duration = atof(optarg); break;
+            case 'r': lg.rate = atof(optarg); break;
+            case 'C': lg.keep_alive = 0; break;
+            case 'j': json = 1; break;
+            case 'a': address = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'u': path = optarg; break;
+            case 'H': header = optarg; break;
+            default: usage();
+        }
+    }
+
+    if (lg.connections < 1 || lg.connections > CONNECTIONS_MAX || lg.duration <= 0 || lg.rate < 0) {
+        usage();
+    }
+
+    lg.address.sin_family = AF_INET;
+    lg.address.sin_port = htons(port);
+    if (inet_pton(AF_INET, address, &lg.address.sin_addr) != 1) {
+        fprintf(stderr, "Error: Invalid address \"%s\"\n", address);
+        exit(EXIT_FAILURE);
+    }
+
+    lg.request_length = snprintf(lg.request, sizeof(lg.request),
+                                 "GET %s HTTP/1.1\r\nHost: %s:%d\r\n%s%s%s\r\n", path, address, port,
+                                 header ? header : "", header ? "\r\n" : "",
+                                 lg.keep_alive ? "" : "Connection: close\r\n");
+    if (lg.request_length >= sizeof(lg.request)) {
+        fprintf(stderr, "Error: Path is too long\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (lg.rate) {
+        lg.interval = (uint64_t)(NSEC * lg.connections / lg.rate);
+    }
+
+    lg.clients = calloc(lg.connections, sizeof(struct client));
+    lg.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!lg.clients || lg.epfd < 0) {
+        fprintf(stderr, "Error: Can't allocate connections\n");
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    elapsed = loadgen_run(&lg);
+    loadgen_report(&lg, elapsed, json);
+
+    free(lg.clients);
+    close(lg.epfd);
+    return lg.requests > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
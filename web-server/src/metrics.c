@@ -0,0 +1,263 @@
+/* Name: Metrics of the web server */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "metrics.h"
+
+
+#define METRICS_BUCKET_NS   1024        /* Upper bound of the first latency bucket */
+#define METRICS_BUFSIZE     8192
+
+
+/* Slots of all workers, shared between worker processes */
+static struct metrics *metrics_slots;
+static int metrics_workers;
+
+static const int status_codes[METRICS_STATUSES] = { 200, 304, 400, 404, 405, 503 };
+
+/* Names used in `-b` and in the `backend` label */
+const char *metrics_backend_names[METRICS_BACKENDS] = {
+    "epoll",
+    "uring"
+};
+
+
+/**
+ *  Allocate counters of all workers before they are started
+ *  @param workers  number of workers
+ *  @return counters of the first worker, the others follow it
+ */
+struct metrics *metrics_init(int workers)
+{
+    metrics_slots = mmap(NULL, sizeof(struct metrics) * workers, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (metrics_slots == MAP_FAILED) {
+        fprintf(stderr, "Error: Can't allocate metrics\n");
+        exit(EXIT_FAILURE);
+    }
+
+    metrics_workers = workers;
+    return metrics_slots;
+}
+
+
+/**
+ *  Add the latency to the histogram
+ *  @param histogram    latency histogram of the own worker
+ *  @param nanoseconds  latency
+ */
+void metrics_record(struct metrics_histogram *histogram, uint64_t nanoseconds)
+{
+    // Bucket `i` holds latencies up to `METRICS_BUCKET_NS << i`
+    int bucket = nanoseconds <= METRICS_BUCKET_NS ? 0 :
+                 64 - __builtin_clzll((nanoseconds - 1) / METRICS_BUCKET_NS);
+
+    if (bucket > METRICS_BUCKETS) {
+        bucket = METRICS_BUCKETS;
+    }
+
+    metrics_add(&histogram->buckets[bucket], 1);
+    metrics_add(&histogram->sum, nanoseconds);
+    metrics_add(&histogram->count, 1);
+}
+
+
+/**
+ *  Counter index of the response status
+ *  @param status   HTTP status code
+ *  @return index in `requests`
+ */
+int metrics_status(int status)
+{
+    int i;
+
+    for (i = 0; i < METRICS_STATUSES; i++) {
+        if (status_codes[i] == status) {
+            return i;
+        }
+    }
+
+    return METRICS_400;
+}
+
+
+static uint64_t metrics_load(const uint64_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+
+/**
+ *  Sum the counters of all workers
+ *  @param total    aggregated counters
+ */
+static void metrics_aggregate(struct metrics *total)
+{
+    const uint64_t *slot;
+    uint64_t *sum = (uint64_t *)total;
+    size_t fields = sizeof(struct metrics) / sizeof(uint64_t);
+    size_t i;
+    int worker;
+
+    memset(total, 0, sizeof(*total));
+
+    // All fields are counters, so the structures are summed as arrays
+    for (worker = 0; worker < metrics_workers; worker++) {
+        slot = (const uint64_t *)&metrics_slots[worker];
+        for (i = 0; i < fields; i++) {
+            sum[i] += metrics_load(&slot[i]);
+        }
+    }
+}
+
+
+/**
+ *  Append formatted text to the growing buffer
+ *  @return 0 on success or -1 on allocation error
+ */
+static int metrics_append(char **buffer, size_t *length, size_t *capacity, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static int metrics_append(char **buffer, size_t *length, size_t *capacity, const char *format, ...)
+{
+    va_list args;
+    int n;
+
+    while (1) {
+        va_start(args, format);
+        n = vsnprintf(*buffer + *length, *capacity - *length, format, args);
+        va_end(args);
+
+        if (n < 0) {
+            return -1;
+        }
+
+        if ((size_t)n < *capacity - *length) {
+            *length += n;
+            return 0;
+        }
+
+        char *bigger = realloc(*buffer, *capacity * 2);
+        if (!bigger) {
+            return -1;
+        }
+        *buffer = bigger;
+        *capacity *= 2;
+    }
+}
+
+
+/**
+ *  Format the histogram as Prometheus cumulative buckets
+ *  @return 0 on success or -1 on allocation error
+ */
+static int metrics_append_histogram(char **buffer, size_t *length, size_t *capacity,
+                                    const char *name, const char *help,
+                                    const struct metrics_histogram *histogram)
+{
+    uint64_t cumulative = 0;
+    int i;
+
+    if (metrics_append(buffer, length, capacity, "# HELP %s %s\n# TYPE %s histogram\n",
+                       name, help, name) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < METRICS_BUCKETS; i++) {
+        cumulative += histogram->buckets[i];
+        if (metrics_append(buffer, length, capacity, "%s_bucket{le=\"%.9g\"} %llu\n", name,
+                           (double)((uint64_t)METRICS_BUCKET_NS << i) / 1e9,
+                           (unsigned long long)cumulative) < 0) {
+            return -1;
+        }
+    }
+
+    return metrics_append(buffer, length, capacity,
+                          "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n",
+                          name, (unsigned long long)histogram->count,
+                          name, histogram->sum / 1e9,
+                          name, (unsigned long long)histogram->count);
+}
+
+
+/**
+ *  Format the counters of all workers in the Prometheus text format
+ *  @param length   length of the text
+ *  @return allocated text or NULL on allocation error
+ */
+char *metrics_format(size_t *length)
+{
+    struct metrics total;
+    size_t capacity = METRICS_BUFSIZE;
+    char *buffer = malloc(capacity);
+    int status = 0;
+    int i;
+
+    if (!buffer) {
+        return NULL;
+    }
+
+    *length = 0;
+    metrics_aggregate(&total);
+
+    status |= metrics_append(&buffer, length, &capacity,
+        "# HELP webserver_connections_accepted_total Accepted connections.\n"
+        "# TYPE webserver_connections_accepted_total counter\n"
+        "webserver_connections_accepted_total %llu\n"
+        "# HELP webserver_connections_active Open connections.\n"
+        "# TYPE webserver_connections_active gauge\n"
+        "webserver_connections_active %llu\n"
+        "# HELP webserver_received_bytes_total Bytes received from clients.\n"
+        "# TYPE webserver_received_bytes_total counter\n"
+        "webserver_received_bytes_total %llu\n"
+        "# HELP webserver_sent_bytes_total Bytes sent to clients.\n"
+        "# TYPE webserver_sent_bytes_total counter\n"
+        "webserver_sent_bytes_total %llu\n"
+        "# HELP webserver_requests_total Requests by response status.\n"
+        "# TYPE webserver_requests_total counter\n",
+        (unsigned long long)total.accepted,
+        (unsigned long long)(total.accepted - total.closed),
+        (unsigned long long)total.bytes_in,
+        (unsigned long long)total.bytes_out);
+
+    for (i = 0; i < METRICS_STATUSES; i++) {
+        status |= metrics_append(&buffer, length, &capacity,
+                                 "webserver_requests_total{status=\"%d\"} %llu\n",
+                                 status_codes[i], (unsigned long long)total.requests[i]);
+    }
+
+    status |= metrics_append(&buffer, length, &capacity,
+        "# HELP webserver_workers Workers by the event loop they run.\n"
+        "# TYPE webserver_workers gauge\n");
+
+    for (i = 0; i < METRICS_BACKENDS; i++) {
+        status |= metrics_append(&buffer, length, &capacity,
+                                 "webserver_workers{backend=\"%s\"} %llu\n",
+                                 metrics_backend_names[i], (unsigned long long)total.backends[i]);
+    }
+
+    status |= metrics_append_histogram(&buffer, length, &capacity, "webserver_accept_seconds",
+                                       "Time from accepting a connection to receiving its first request.",
+                                       &total.accept);
+    status |= metrics_append_histogram(&buffer, length, &capacity, "webserver_parse_seconds",
+                                       "Time to parse a request and prepare its response.",
+                                       &total.parse);
+    status |= metrics_append_histogram(&buffer, length, &capacity, "webserver_write_seconds",
+                                       "Time from a prepared response to the end of its sending.",
+                                       &total.write);
+
+    if (status < 0) {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+
+#define METRICS_PATH        "/metrics"
+#define METRICS_BUCKETS     21          /* Latency buckets from ~1 us to ~1 s, powers of two */
+#define METRICS_SAMPLE      8           /* Latency of every 8th request and connection is measured */
+
+
+/* Response statuses counted separately */
+enum metrics_status {
+    METRICS_200,
+    METRICS_304,
+    METRICS_400,
+    METRICS_404,
+    METRICS_405,
+    METRICS_503,
+    METRICS_STATUSES                    /* This necessary to get number of statuses */
+};
+
+
+/* Event loops a worker can run, in the order of `enum backend` */
+enum metrics_backend {
+    METRICS_EPOLL,
+    METRICS_URING,
+    METRICS_BACKENDS
+};
+
+
+/* Latency histogram, the last bucket counts everything above the others */
+struct metrics_histogram {
+    uint64_t buckets[METRICS_BUCKETS + 1];
+    uint64_t sum;                       /* Nanoseconds */
+    uint64_t count;
+};
+
+
+/* Counters of one worker, written only by it and summed on demand */
+struct metrics {
+    uint64_t accepted;
+    uint64_t closed;
+    uint64_t backends[METRICS_BACKENDS];    /* 1 for the event loop the worker runs, after a fallback too */
+    uint64_t requests[METRICS_STATUSES];
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    struct metrics_histogram accept;    /* Accepted connection until its first request is received */
+    struct metrics_histogram parse;     /* Parsing the request and preparing the response */
+    struct metrics_histogram write;     /* Response ready until it is completely sent */
+} __attribute__((aligned(64)));
+
+
+/**
+ *  Single writer increment, readers in other workers see whole values without locks
+ *  @param counter  counter of the own worker
+ *  @param value    increment
+ */
+static inline void metrics_add(uint64_t *counter, uint64_t value)
+{
+    __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+
+/**
+ *  Monotonic time for latency measurements
+ *  @return time in nanoseconds
+ */
+static inline uint64_t metrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+extern const char *metrics_backend_names[METRICS_BACKENDS];
+
+
+struct metrics *metrics_init(int workers);
+void metrics_record(struct metrics_histogram *histogram, uint64_t nanoseconds);
+int metrics_status(int status);
+char *metrics_format(size_t *length);
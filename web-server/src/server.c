@@ -1,44 +1,111 @@
 /* Name: Web Server implementation */
 /* Author: Egor Bronnikov */
-/* Last edited: 18-07-2022 */
+/* Last edited: 19-10-2026 */
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
+#include <signal.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 #include <netinet/ip.h>
 
+#include "cache.h"
 #include "server.h"
+#include "metrics.h"
 
 
 #define PORT 5555
-#define BACKLOG 10
-#define REQUEST "../example"
+#define BACKLOG 4096
+#define ROOT "../example"
+#define LOGFILE "/var/log/webserver.log"
+#define WORKERS_MAX 64
+#define METRICS_HEADER_MAX 256
 
+#define STATIC_RESPONSE(header, body)   { header, sizeof(header) - 1, body, sizeof(body) - 1 }
 
-int main(void)
+
+/* Response that does not depend on the requested file */
+struct static_response {
+    const char *header;             /* Status line and headers, without `Date` */
+    size_t header_length;
+    const char *body;
+    size_t body_length;
+};
+
+
+static const struct static_response bad_request = STATIC_RESPONSE(
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Server: WebServer\r\n"
+    "Content-Type: text/plain; charset=UTF-8\r\n"
+    "Content-Length: 12\r\n",
+    "Bad Request\n");
+
+static const struct static_response not_found = STATIC_RESPONSE(
+    "HTTP/1.1 404 Not Found\r\n"
+    "Server: WebServer\r\n"
+    "Content-Type: text/plain; charset=UTF-8\r\n"
+    "Content-Length: 10\r\n",
+    "Not Found\n");
+
+static const struct static_response method_not_allowed = STATIC_RESPONSE(
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Server: WebServer\r\n"
+    "Allow: GET, HEAD\r\n"
+    "Content-Type: text/plain; charset=UTF-8\r\n"
+    "Content-Length: 19\r\n",
+    "Method Not Allowed\n");
+
+static const struct static_response service_unavailable = STATIC_RESPONSE(
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Server: WebServer\r\n"
+    "Content-Type: text/plain; charset=UTF-8\r\n"
+    "Content-Length: 20\r\n",
+    "Service Unavailable\n");
+
+/* Last header line and the end of headers */
+static const struct static_response headers_end = STATIC_RESPONSE("\r\n", "");
+
+static const struct static_response connection_close = STATIC_RESPONSE(
+    "Connection: close\r\n\r\n", "");
+
+static const struct static_response connection_keep_alive = STATIC_RESPONSE(
+    "Connection: keep-alive\r\n\r\n", "");
+
+
+/**
+ *  Open listening socket, all workers bind the same port
+ *  @param port     server port
+ *  @return socket file descriptor
+ */
+static int open_listener(int port)
 {
     int sockfd;
+    int enable = 1;
     struct sockaddr_in servaddr;
-    
+
     memset(&servaddr, 0, sizeof(servaddr));
 
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 
     if (sockfd < 0) {
         fprintf(stderr, "Error: Can't open socket\n");
         exit(EXIT_FAILURE);
     }
 
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
     servaddr.sin_family = AF_INET;
     servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    servaddr.sin_port = htons(PORT);
-    
-    int address_length = sizeof(servaddr);
+    servaddr.sin_port = htons(port);
 
-    if (bind(sockfd, (struct sockaddr*)&servaddr, address_length) < 0) {
+    if (bind(sockfd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
         fprintf(stderr, "Error: Failed to bind socket\n");
         exit(EXIT_FAILURE);
     }
@@ -46,60 +113,808 @@ int main(void)
     if (listen(sockfd, BACKLOG) < 0) {
         fprintf(stderr, "Error: Listen failed\n");
         exit(EXIT_FAILURE);
-    } else {
-        fprintf(stdout, "Server is listening...\n\n");
     }
-    
-    launch(sockfd, servaddr, address_length);
 
-    close(sockfd);
+    return sockfd;
 }
 
 
-/**
- *  Listen connections for server
- *  @param sockfd           socket file descriptor
- *  @param servaddr         server address
- *  @param address_length   server address length
- */
-void launch(int sockfd, struct sockaddr_in servaddr, int address_length)
+int main(int argc, char **argv)
 {
-    char buffer[BUFSIZ];
-    long length;
+    enum backend backend = BACKEND_EPOLL;
+    const char *logpath = LOGFILE;
+    int workers = 1;
+    int port = PORT;
+    int opt, i;
 
-    FILE *file_request = fopen(REQUEST, "r");
-    FILE *logfile = fopen("/var/log/webserver.log", "w");
+    while ((opt = getopt(argc, argv, "b:w:p:l:")) != -1) {
+        switch (opt) {
+            case 'b':
+                if (strcmp(optarg, "epoll") == 0) {
+                    backend = BACKEND_EPOLL;
+                } else if (strcmp(optarg, "uring") == 0) {
+                    backend = BACKEND_URING;
+                } else {
+                    fprintf(stderr, "Error: Unknown backend \"%s\"\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'w':
+                workers = atoi(optarg);
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'l':
+                logpath = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: server [-b epoll|uring] [-w workers] [-p port] [-l logfile]\n");
+                exit(EXIT_FAILURE);
+        }
+    }
 
-    if (!file_request) {
-        fprintf(stderr, "Error: File can't be opened\n");
+    if (workers < 1 || workers > WORKERS_MAX) {
+        fprintf(stderr, "Error: Number of workers must be from 1 to %d\n", WORKERS_MAX);
         exit(EXIT_FAILURE);
     }
 
+    // Writes to closed connections are reported by `EPIPE`
+    signal(SIGPIPE, SIG_IGN);
+
+    FILE *logfile = fopen(logpath, "w");
+
     if (!logfile) {
         fprintf(stderr, "Error: Can't open logfile\n");
         exit(EXIT_FAILURE);
     }
 
-    fseek(file_request, 0, SEEK_END);
-    length = ftell(file_request);
-    fseek(file_request, 0, SEEK_SET);
+    // Each worker gets its own socket and the kernel balances connections between them
+    int sockfds[WORKERS_MAX];
+    struct metrics *metrics = metrics_init(workers);
+
+    for (i = 0; i < workers; i++) {
+        sockfds[i] = open_listener(port);
+    }
+
+    fprintf(stdout, "Server is listening...\n\n");
+    fflush(stdout);
+
+    if (workers == 1) {
+        launch(sockfds[0], backend, logfile, &metrics[0]);
+        close(sockfds[0]);
+        return 0;
+    }
+
+    for (i = 0; i < workers; i++) {
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            int j;
+            for (j = 0; j < workers; j++) {
+                if (j != i) {
+                    close(sockfds[j]);
+                }
+            }
+            launch(sockfds[i], backend, logfile, &metrics[i]);
+            exit(EXIT_SUCCESS);
+        } else if (pid < 0) {
+            fprintf(stderr, "Error: Can't start worker\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    while (wait(NULL) > 0);
+
+    return 0;
+}
+
+
+/**
+ *  Find the end of the request headers
+ *  @param buffer   received data
+ *  @param length   received data length
+ *  @return pointer past the empty line or NULL if headers are incomplete
+ */
+static const char *http_headers_end(const char *buffer, size_t length)
+{
+    size_t i;
+
+    for (i = 3; i < length; i++) {
+        if (buffer[i] == '\n' && buffer[i - 1] == '\r' &&
+            buffer[i - 2] == '\n' && buffer[i - 3] == '\r') {
+            return buffer + i + 1;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ *  Check if the header value starts with the token, ignoring case
+ *  @param value    header value
+ *  @param end      end of the header value
+ *  @param token    expected token
+ *  @return 1 if the value matches else 0
+ */
+static int http_header_is(const char *value, const char *end, const char *token)
+{
+    size_t length = strlen(token);
+    return (size_t)(end - value) >= length && strncasecmp(value, token, length) == 0;
+}
+
+
+/**
+ *  Parse the `Accept-Encoding` list, codings with zero quality are not accepted
+ *  @param value    header value
+ *  @param end      end of the header value
+ *  @return bit mask of accepted codings, `1 << encoding`
+ */
+static unsigned http_accept_encoding(const char *value, const char *end)
+{
+    unsigned encodings = 1u << ENCODING_IDENTITY;
+
+    while (value < end) {
+        const char *comma = memchr(value, ',', end - value);
+        const char *item_end = comma ? comma : end;
+        const char *params = memchr(value, ';', item_end - value);
+        const char *name_end = params ? params : item_end;
+        int i;
+
+        while (value < name_end && *value == ' ') value++;
+        while (name_end > value && name_end[-1] == ' ') name_end--;
+
+        // q=0, q=0.0, q=0.000 mean "not acceptable"
+        if (params) {
+            const char *q = params + 1;
+            while (q < item_end && *q == ' ') q++;
+            if (item_end - q >= 3 && q[0] == 'q' && q[1] == '=' && q[2] == '0' &&
+                strspn(q + 3, ".0") >= (size_t)(item_end - q - 3)) {
+                value = comma ? comma + 1 : end;
+                continue;
+            }
+        }
+
+        for (i = 0; i < ENCODINGS; i++) {
+            size_t length = strlen(encoding_names[i]);
+            if ((size_t)(name_end - value) == length && strncasecmp(value, encoding_names[i], length) == 0) {
+                encodings |= 1u << i;
+            }
+        }
+        if (name_end - value == 1 && *value == '*') {
+            encodings = ~0u;
+        }
+
+        value = comma ? comma + 1 : end;
+    }
+
+    return encodings;
+}
+
+
+/**
+ *  Collapse empty and `.` segments of the path in place, so every file has one cache key
+ *  @param path     request path, starts with '/'
+ */
+static void http_normalize_path(char *path)
+{
+    const char *src = path;
+    char *dst = path;
+
+    while (*src) {
+        if (src[0] == '/' && (src[1] == '/' || (src[1] == '.' && (src[2] == '/' || src[2] == '\0')))) {
+            // `//` and `/./` become `/`, a trailing `/.` becomes `/`
+            src += src[1] == '/' ? 1 : 2;
+            if (*src == '\0') {
+                *dst++ = '/';
+            }
+            continue;
+        }
+        *dst++ = *src++;
+    }
+
+    *dst = '\0';
+}
+
+
+/**
+ *  Parse the request line and the headers the server cares about
+ *  @param buffer   received data
+ *  @param length   received data length
+ *  @param request  parsed request
+ *  @return 1 if the request is complete, 0 if more data is needed, -1 if it is malformed
+ */
+int http_parse(const char *buffer, size_t length, struct http_request *request)
+{
+    const char *end = http_headers_end(buffer, length);
+    const char *ptr, *line_end, *path, *path_end, *version;
+
+    if (!end) {
+        return 0;
+    }
+
+    request->length = end - buffer;
+    request->if_none_match = NULL;
+    request->if_none_match_length = 0;
+    request->encodings = 1u << ENCODING_IDENTITY;
+    request->http10 = 0;
+
+    // Request line: METHOD SP PATH SP VERSION CRLF
+    line_end = memchr(buffer, '\r', end - buffer);
+    ptr = memchr(buffer, ' ', line_end - buffer);
+    if (!ptr) {
+        return -1;
+    }
+    request->method = buffer;
+    request->method_length = ptr - buffer;
+
+    path = ptr + 1;
+    path_end = memchr(path, ' ', line_end - path);
+    if (!path_end || *path != '/' || path_end - path >= (long)sizeof(request->path)) {
+        return -1;
+    }
+
+    version = path_end + 1;
+    if (line_end - version != 8 || memcmp(version, "HTTP/1.", 7) != 0) {
+        return -1;
+    }
+    request->http10 = version[7] == '0';
+    request->keep_alive = !request->http10;
+
+    // Query string is not a part of the cache key
+    ptr = memchr(path, '?', path_end - path);
+    if (ptr) {
+        path_end = ptr;
+    }
+    memcpy(request->path, path, path_end - path);
+    request->path[path_end - path] = '\0';
+    http_normalize_path(request->path);
+
+    // Never leave the document root
+    if (strstr(request->path, "/..")) {
+        return -1;
+    }
+
+    // Headers: NAME ":" VALUE CRLF
+    for (ptr = line_end + 2; ptr < end - 2; ptr = line_end + 2) {
+        const char *value;
+
+        line_end = memchr(ptr, '\r', end - ptr);
+        value = memchr(ptr, ':', line_end - ptr);
+        if (!value) {
+            return -1;
+        }
+        for (value++; value < line_end && *value == ' '; value++);
+
+        if (http_header_is(ptr, line_end, "If-None-Match:")) {
+            request->if_none_match = value;
+            request->if_none_match_length = line_end - value;
+        } else if (http_header_is(ptr, line_end, "Accept-Encoding:")) {
+            request->encodings = http_accept_encoding(value, line_end);
+        } else if (http_header_is(ptr, line_end, "Connection:")) {
+            if (http_header_is(value, line_end, "close")) {
+                request->keep_alive = 0;
+            } else if (http_header_is(value, line_end, "keep-alive")) {
+                request->keep_alive = 1;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+/**
+ *  Check if the entity tag is in the `If-None-Match` list
+ *  @param request  parsed request
+ *  @param etag     quoted entity tag
+ *  @return 1 if the client already has this entity else 0
+ */
+static int http_etag_matches(const struct http_request *request, const char *etag)
+{
+    const char *ptr = request->if_none_match;
+    const char *end = ptr + request->if_none_match_length;
+    size_t etag_length = strlen(etag);
+
+    while (ptr < end) {
+        const char *comma = memchr(ptr, ',', end - ptr);
+        const char *item_end = comma ? comma : end;
+
+        while (ptr < item_end && *ptr == ' ') ptr++;
+        if (item_end - ptr >= 2 && ptr[0] == 'W' && ptr[1] == '/') ptr += 2;
+        while (item_end > ptr && item_end[-1] == ' ') item_end--;
+
+        if ((item_end - ptr == 1 && *ptr == '*') ||
+            ((size_t)(item_end - ptr) == etag_length && memcmp(ptr, etag, etag_length) == 0)) {
+            return 1;
+        }
+
+        ptr = comma ? comma + 1 : end;
+    }
+
+    return 0;
+}
+
+
+/**
+ *  Compare the request method
+ *  @param request  parsed request
+ *  @param method   method name, e.g. "GET"
+ *  @return 1 if the request uses the method else 0
+ */
+static int http_method_is(const struct http_request *request, const char *method)
+{
+    size_t length = strlen(method);
+
+    return request->method_length == length && memcmp(request->method, method, length) == 0;
+}
+
+
+/**
+ *  Fill the `Date` header and the end of headers
+ *  @param cache        response cache
+ *  @param keep_alive   connection is kept open after the response
+ *  @param http10       client speaks HTTP/1.0 and needs explicit keep-alive
+ *  @param iov          output vector, `Date` goes to iov[1] and the rest to iov[2]
+ */
+static void http_headers_tail(struct cache *cache, int keep_alive, int http10, struct iovec *iov)
+{
+    const struct static_response *tail;
+
+    if (!keep_alive) {
+        tail = &connection_close;
+    } else if (http10) {
+        tail = &connection_keep_alive;
+    } else {
+        tail = &headers_end;
+    }
+
+    cache_update_date(cache);
+
+    iov[1].iov_base = cache->date;
+    iov[1].iov_len = cache->date_length;
+    iov[2].iov_base = (void *)tail->header;
+    iov[2].iov_len = tail->header_length;
+}
+
+
+/**
+ *  Fill the response from prebuilt buffers, nothing is formatted here
+ *  @param cache    response cache
+ *  @param request  parsed request, `keep_alive` is cleared if the connection must be closed
+ *  @param iov      output vector, at least `RESPONSE_IOV` elements
+ *  @param entry    referenced cache entry, NULL if the response does not use the cache
+ *  @return number of used elements of `iov`
+ */
+int http_response(struct cache *cache, struct http_request *request,
+                  struct iovec *iov, struct cache_entry **entry)
+{
+    const struct static_response *response = NULL;
+    const struct cache_variant *variant;
+    int head = 0;
+
+    *entry = NULL;
+
+    if (http_method_is(request, "HEAD")) {
+        head = 1;
+    } else if (!http_method_is(request, "GET")) {
+        // The request may have a body we are not going to read
+        response = &method_not_allowed;
+        request->keep_alive = 0;
+        request->status = 405;
+    }
+
+    if (!response) {
+        *entry = cache_lookup(cache, request->path);
+        if (!*entry && errno == ENOMEM) {
+            response = &service_unavailable;
+            request->keep_alive = 0;
+            request->status = 503;
+        } else if (!*entry) {
+            response = &not_found;
+            request->status = 404;
+        }
+    }
+
+    http_headers_tail(cache, request->keep_alive, request->http10, iov);
+
+    if (response) {
+        iov[0].iov_base = (void *)response->header;
+        iov[0].iov_len = response->header_length;
+        iov[3].iov_base = (void *)response->body;
+        iov[3].iov_len = response->body_length;
+        return head ? 3 : 4;
+    }
+
+    // Every coding has its own entity tag, so 304 is checked for the chosen one
+    variant = cache_variant(*entry, request->encodings);
+
+    if (request->if_none_match && http_etag_matches(request, variant->etag)) {
+        iov[0].iov_base = variant->not_modified;
+        iov[0].iov_len = variant->not_modified_length;
+        request->status = 304;
+        return 3;
+    }
+
+    iov[0].iov_base = variant->header;
+    iov[0].iov_len = variant->header_length;
+    iov[3].iov_base = variant->body;
+    iov[3].iov_len = variant->body_length;
+    request->status = 200;
+    return head ? 3 : 4;
+}
+
+
+/**
+ *  Fill the `400 Bad Request` response, the connection is closed after it
+ *  @param cache    response cache
+ *  @param iov      output vector, at least `RESPONSE_IOV` elements
+ *  @return number of used elements of `iov`
+ */
+int http_bad_request(struct cache *cache, struct iovec *iov)
+{
+    http_headers_tail(cache, 0, 0, iov);
+
+    iov[0].iov_base = (void *)bad_request.header;
+    iov[0].iov_len = bad_request.header_length;
+    iov[3].iov_base = (void *)bad_request.body;
+    iov[3].iov_len = bad_request.body_length;
+    return 4;
+}
+
+
+/**
+ *  Fill the `503 Service Unavailable` response for a request the server has no memory for,
+ *  the connection is closed after it
+ *  @param cache    response cache
+ *  @param head     request is `HEAD`, the body is not sent
+ *  @param iov      output vector, at least `RESPONSE_IOV` elements
+ *  @return number of used elements of `iov`
+ */
+static int http_service_unavailable(struct cache *cache, int head, struct iovec *iov)
+{
+    http_headers_tail(cache, 0, 0, iov);
+
+    iov[0].iov_base = (void *)service_unavailable.header;
+    iov[0].iov_len = service_unavailable.header_length;
+    iov[3].iov_base = (void *)service_unavailable.body;
+    iov[3].iov_len = service_unavailable.body_length;
+    return head ? 3 : 4;
+}
+
+
+/**
+ *  Fill the response with counters of all workers, it is formatted on every request
+ *  @param cache        response cache
+ *  @param request      parsed request, `keep_alive` is cleared if the text can't be allocated
+ *  @param iov          output vector, at least `RESPONSE_IOV` elements
+ *  @param generated    allocated header and body, freed after the response is sent
+ *  @return number of used elements of `iov`
+ */
+static int http_metrics(struct cache *cache, struct http_request *request,
+                        struct iovec *iov, char **generated)
+{
+    int head = http_method_is(request, "HEAD");
+    char header[METRICS_HEADER_MAX];
+    size_t body_length, header_length;
+    char *body = metrics_format(&body_length);
+    char *response = NULL;
+
+    if (body) {
+        header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.1 200 OK\r\n"
+                                 "Server: WebServer\r\n"
+                                 "Content-Type: text/plain; version=0.0.4; charset=UTF-8\r\n"
+                                 "Cache-Control: no-store\r\n"
+                                 "Content-Length: %zu\r\n", body_length);
+
+        // Header goes after the body, so both live in one allocation
+        response = realloc(body, body_length + header_length);
+        if (!response) {
+            free(body);
+        }
+    }
+
+    // Out of memory is the server's fault, not the client's
+    if (!response) {
+        request->keep_alive = 0;
+        request->status = 503;
+        return http_service_unavailable(cache, head, iov);
+    }
+
+    memcpy(response + body_length, header, header_length);
+    *generated = response;
+
+    http_headers_tail(cache, request->keep_alive, request->http10, iov);
+
+    iov[0].iov_base = response + body_length;
+    iov[0].iov_len = header_length;
+    iov[3].iov_base = response;
+    iov[3].iov_len = body_length;
+    request->status = 200;
+    return head ? 3 : 4;
+}
+
+
+/**
+ *  Prepare the new connection
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ *  @param fd       socket or fixed file index
+ */
+void connection_init(struct worker *worker, struct connection *conn, int fd)
+{
+    conn->fd = fd;
+    conn->keep_alive = 0;
+    conn->length = 0;
+    conn->request_length = 0;
+    conn->entry = NULL;
+    conn->generated = NULL;
+    conn->stream_remaining = 0;
+    conn->accepted = worker->metrics->accepted % METRICS_SAMPLE == 0 ? metrics_now() : 0;
+    conn->ready = 0;
+    conn->iov_index = 0;
+    conn->iovcnt = 0;
+
+    metrics_add(&worker->metrics->accepted, 1);
+}
+
+
+/**
+ *  Account the received data
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ *  @param length   number of bytes received into the buffer
+ */
+void connection_received(struct worker *worker, struct connection *conn, size_t length)
+{
+    conn->length += length;
+    metrics_add(&worker->metrics->bytes_in, length);
+}
+
+
+/**
+ *  Parse the received data and prepare the response
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ *  @return 1 if the response is ready to be sent, 0 if more data is needed
+ */
+int connection_process(struct worker *worker, struct connection *conn)
+{
+    struct metrics *metrics = worker->metrics;
+    struct http_request request;
+    uint64_t start;
+    int status;
+
+    if (conn->length == 0) {
+        return 0;
+    }
+
+    // Reading the clock costs more than the counters, so latency is measured for a sample
+    start = conn->accepted || worker->samples++ % METRICS_SAMPLE == 0 ? metrics_now() : 0;
+    status = http_parse(conn->buffer, conn->length, &request);
+
+    if (status == 0 && conn->length < CONNECTION_BUFSIZE) {
+        return 0;
+    }
+
+    if (conn->accepted) {
+        metrics_record(&metrics->accept, start - conn->accepted);
+        conn->accepted = 0;
+    }
+
+    if (status == 1) {
+        fprintf(worker->logfile, "%.*s\n", (int)request.length, conn->buffer);
+        // Counters are only read, other methods get `405` from `http_response()` as files do
+        if (strcmp(request.path, METRICS_PATH) == 0 &&
+            (http_method_is(&request, "GET") || http_method_is(&request, "HEAD"))) {
+            conn->iovcnt = http_metrics(&worker->cache, &request, conn->iov, &conn->generated);
+        } else {
+            conn->iovcnt = http_response(&worker->cache, &request, conn->iov, &conn->entry);
+
+            // The body of a large file is read by parts into the connection as they are sent
+            if (conn->entry && conn->entry->fd >= 0 && conn->iovcnt == RESPONSE_IOV) {
+                conn->generated = malloc(CONNECTION_STREAM_CHUNK);
+                if (conn->generated) {
+                    conn->stream_offset = 0;
+                    conn->stream_remaining = conn->entry->variants[ENCODING_IDENTITY].body_length;
+                    conn->iovcnt = RESPONSE_IOV - 1;
+                } else {
+                    connection_release(conn);
+                    conn->iovcnt = http_service_unavailable(&worker->cache, 0, conn->iov);
+                    request.keep_alive = 0;
+                    request.status = 503;
+                }
+            }
+        }
+        conn->keep_alive = request.keep_alive;
+        conn->request_length = request.length;
+    } else {
+        // Malformed request or headers do not fit into the buffer
+        fprintf(worker->logfile, "%.*s\n", (int)conn->length, conn->buffer);
+        conn->iovcnt = http_bad_request(&worker->cache, conn->iov);
+        conn->keep_alive = 0;
+        conn->request_length = conn->length;
+        request.status = 400;
+    }
+
+    // A slow send may outlive the second, the line in the cache is rewritten then
+    memcpy(conn->date, conn->iov[1].iov_base, conn->iov[1].iov_len);
+    conn->iov[1].iov_base = conn->date;
+    conn->iov_index = 0;
+    conn->ready = 0;
+
+    if (start) {
+        conn->ready = metrics_now();
+        metrics_record(&metrics->parse, conn->ready - start);
+    }
+
+    metrics_add(&metrics->requests[metrics_status(request.status)], 1);
+    return 1;
+}
+
+
+/**
+ *  Read the next part of the streamed file into the connection
+ *  @param conn     connection with a streamed file
+ *  @return 0 if the part is ready to be sent or -1 if the file can't be read
+ */
+static int connection_stream(struct connection *conn)
+{
+    size_t length = conn->stream_remaining < CONNECTION_STREAM_CHUNK ?
+                    conn->stream_remaining : CONNECTION_STREAM_CHUNK;
+    ssize_t n = pread(conn->entry->fd, conn->generated, length, conn->stream_offset);
+
+    if (n <= 0) {
+        return -1;
+    }
+
+    conn->stream_offset += n;
+    conn->stream_remaining -= n;
+    conn->iov[0].iov_base = conn->generated;
+    conn->iov[0].iov_len = n;
+    conn->iov_index = 0;
+    conn->iovcnt = 1;
+    return 0;
+}
+
+
+/**
+ *  Skip sent bytes of the response
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ *  @param length   number of sent bytes
+ *  @return 1 if the whole response is sent else 0
+ */
+int connection_sent(struct worker *worker, struct connection *conn, size_t length)
+{
+    struct iovec *iov;
+
+    metrics_add(&worker->metrics->bytes_out, length);
+
+    while (conn->iovcnt > 0) {
+        iov = &conn->iov[conn->iov_index];
+
+        if (length < iov->iov_len) {
+            iov->iov_base = (char *)iov->iov_base + length;
+            iov->iov_len -= length;
+            return 0;
+        }
+
+        length -= iov->iov_len;
+        conn->iov_index++;
+        conn->iovcnt--;
+    }
+
+    if (conn->stream_remaining > 0) {
+        if (connection_stream(conn) == 0) {
+            return 0;
+        }
+
+        // The file got shorter, the promised length can't be sent
+        conn->stream_remaining = 0;
+        conn->keep_alive = 0;
+    }
+
+    if (conn->ready) {
+        metrics_record(&worker->metrics->write, metrics_now() - conn->ready);
+        conn->ready = 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ *  Finish the sent response and keep pipelined data for the next one
+ *  @param conn     connection
+ *  @return 1 if the connection is reused, 0 if it must be closed
+ */
+int connection_next(struct connection *conn)
+{
+    connection_release(conn);
+
+    if (!conn->keep_alive) {
+        return 0;
+    }
+
+    conn->length -= conn->request_length;
+    memmove(conn->buffer, conn->buffer + conn->request_length, conn->length);
+    conn->request_length = 0;
+    return 1;
+}
+
+
+/**
+ *  Drop the cached file or generated text referenced by the response
+ *  @param conn     connection
+ */
+void connection_release(struct connection *conn)
+{
+    if (conn->entry) {
+        cache_release(conn->entry);
+        conn->entry = NULL;
+    }
+
+    free(conn->generated);
+    conn->generated = NULL;
+    conn->stream_remaining = 0;
+}
+
+
+/**
+ *  Release the response before the backend closes the connection
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ */
+void connection_end(struct worker *worker, struct connection *conn)
+{
+    connection_release(conn);
+    metrics_add(&worker->metrics->closed, 1);
+}
+
+
+/**
+ *  Report the event loop the worker runs, after a fallback it is not the requested one
+ *  @param worker   worker that starts serving
+ *  @param backend  I/O loop implementation
+ */
+void worker_started(struct worker *worker, enum backend backend)
+{
+    enum metrics_backend index = backend == BACKEND_URING ? METRICS_URING : METRICS_EPOLL;
+
+    metrics_add(&worker->metrics->backends[index], 1);
+    fprintf(stdout, "Worker %d runs %s\n", (int)getpid(), metrics_backend_names[index]);
+    fflush(stdout);
+}
+
+
+/**
+ *  Run the worker: serve connections of the listening socket
+ *  @param sockfd   listening socket file descriptor
+ *  @param backend  I/O loop implementation
+ *  @param logfile  requests log
+ *  @param metrics  counters of this worker
+ */
+void launch(int sockfd, enum backend backend, FILE *logfile, struct metrics *metrics)
+{
+    struct worker worker;
 
-    char *http_request = malloc(length);
+    worker.sockfd = sockfd;
+    worker.logfile = logfile;
+    worker.metrics = metrics;
+    worker.samples = 0;
+    cache_init(&worker.cache, ROOT);
 
-    if (http_request) {
-        fread(http_request, 1, length, file_request);
+    if (backend == BACKEND_URING && uring_loop(&worker) < 0) {
+        fprintf(stderr, "Error: io_uring is unavailable, falling back to epoll\n");
+        backend = BACKEND_EPOLL;
     }
 
-    fclose(file_request);
-    
-    while (1) {
-        int accept_sockfd = accept(sockfd, (struct sockaddr*)&servaddr,
-                                   (socklen_t *)&address_length);
-        read(accept_sockfd, buffer, BUFSIZ);
-        fprintf(logfile, "%s\n", buffer);
-        write(accept_sockfd, http_request, strlen(http_request));
-        close(accept_sockfd);
+    if (backend == BACKEND_EPOLL) {
+        epoll_loop(&worker);
     }
 
-    fclose(logfile);
+    cache_free(&worker.cache);
 }
@@ -1,3 +1,86 @@
 #pragma once
 
-void launch(int sockfd, struct sockaddr_in servaddr, int address_length);
+#include <stdio.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "cache.h"
+#include "metrics.h"
+
+
+#define RESPONSE_IOV        4       /* Max number of buffers in one response */
+#define CONNECTION_BUFSIZE  4096    /* Receive buffer size of one connection */
+#define CONNECTION_STREAM_CHUNK (64 * 1024) /* Part of a large file read at once */
+
+
+/* I/O loop implementations, selected at startup */
+enum backend {
+    BACKEND_EPOLL,
+    BACKEND_URING
+};
+
+
+/* Parsed HTTP request, pointers refer to the receive buffer */
+struct http_request {
+    const char *method;
+    size_t method_length;
+    char path[PATH_MAX];
+    const char *if_none_match;      /* `If-None-Match` header value or NULL */
+    size_t if_none_match_length;
+    unsigned encodings;             /* Accepted content codings, `1 << encoding` */
+    size_t length;                  /* Length of the request line and headers */
+    int keep_alive;                 /* Connection can be reused after the response */
+    int http10;                     /* HTTP/1.0 client, keep-alive must be explicit */
+    int status;                     /* Response status, set by `http_response()` */
+};
+
+
+/* Client connection, shared by all backends */
+struct connection {
+    int fd;                         /* Socket or fixed file index */
+    int keep_alive;
+    size_t length;                  /* Number of received bytes in `buffer` */
+    size_t request_length;          /* Number of bytes of the request being answered */
+    struct cache_entry *entry;      /* Cached file referenced by the response */
+    char *generated;                /* Response built for this request only, e.g. metrics, or a part of a streamed file */
+    off_t stream_offset;            /* Offset of the next part of the streamed file */
+    size_t stream_remaining;        /* Bytes of the streamed file not read yet, 0 if not streaming */
+    uint64_t accepted;              /* Accept time until the first request is received, 0 if not sampled */
+    uint64_t ready;                 /* Time the response was ready to be sent, 0 if not sampled */
+    char date[DATE_MAX];            /* `Date` header of the response, the cache refreshes its own line */
+    struct iovec iov[RESPONSE_IOV]; /* Unsent part of the response */
+    int iov_index;
+    int iovcnt;
+    struct msghdr msg;              /* Message for asynchronous sends */
+    char buffer[CONNECTION_BUFSIZE];
+};
+
+
+/* Server process with its own listening socket, cache and I/O loop */
+struct worker {
+    int sockfd;
+    struct cache cache;
+    FILE *logfile;
+    struct metrics *metrics;        /* Counters of this worker, shared with the others */
+    unsigned samples;               /* Requests seen, selects the ones with measured latency */
+};
+
+
+int http_parse(const char *buffer, size_t length, struct http_request *request);
+int http_response(struct cache *cache, struct http_request *request,
+                  struct iovec *iov, struct cache_entry **entry);
+int http_bad_request(struct cache *cache, struct iovec *iov);
+
+void connection_init(struct worker *worker, struct connection *conn, int fd);
+void connection_received(struct worker *worker, struct connection *conn, size_t length);
+int connection_process(struct worker *worker, struct connection *conn);
+int connection_sent(struct worker *worker, struct connection *conn, size_t length);
+int connection_next(struct connection *conn);
+void connection_release(struct connection *conn);
+void connection_end(struct worker *worker, struct connection *conn);
+
+void launch(int sockfd, enum backend backend, FILE *logfile, struct metrics *metrics);
+void worker_started(struct worker *worker, enum backend backend);
+void epoll_loop(struct worker *worker);
+int uring_loop(struct worker *worker);
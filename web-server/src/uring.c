@@ -0,0 +1,519 @@
+/* Name: io_uring backend of the web server */
+/* Author: Egor Bronnikov */
+/* Last edited: 19-10-2026 */
+
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+#include "server.h"
+
+
+#define URING_ENTRIES       1024            /* Submission queue size */
+#define URING_CONNECTIONS   4096            /* Size of the fixed file table */
+
+/* Operation is stored in the low bits of `user_data`, connection index in the rest */
+#define URING_OP_BITS       3
+#define URING_OP_MASK       ((1 << URING_OP_BITS) - 1)
+
+#define load_acquire(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+enum uring_op {
+    URING_ACCEPT,
+    URING_RECV,
+    URING_SEND,
+    URING_CLOSE,
+    URING_POLL,
+    URING_LISTEN
+};
+
+
+/* Mapped submission and completion rings */
+struct uring {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;             /* Prepared but not yet published entries */
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    struct connection *conns;           /* Connection of every fixed file slot */
+    unsigned connections;               /* Open connections, closing one lets a stopped accept go on */
+    int accept_armed;                   /* Multishot accept, or the poll that arms it again, is active */
+    int spare_fd;                       /* Kept open to make room for a connection to drop when out of descriptors */
+};
+
+
+static int uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+
+static int uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+
+/**
+ *  Publish prepared entries and wait for at least one completion
+ *  @param ring     io_uring instance
+ *  @param wait     number of completions to wait for
+ */
+static void uring_submit(struct uring *ring, unsigned wait)
+{
+    unsigned to_submit;
+
+    store_release(ring->sq_tail, ring->sq_local_tail);
+
+    // Entries the kernel has not consumed yet, also the ones left by a failed or partial submission
+    to_submit = ring->sq_local_tail - load_acquire(ring->sq_head);
+    if (to_submit == 0 && wait == 0) {
+        return;
+    }
+
+    while (uring_enter(ring->fd, to_submit, wait, wait ? IORING_ENTER_GETEVENTS : 0) < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            fprintf(stderr, "Error: io_uring_enter failed\n");
+            exit(EXIT_FAILURE);
+        }
+        to_submit = ring->sq_local_tail - load_acquire(ring->sq_head);
+    }
+}
+
+
+/**
+ *  Get the next free submission entry, submitting the full queue if needed
+ *  @param ring     io_uring instance
+ *  @param op       operation stored in `user_data`
+ *  @param index    connection index stored in `user_data`
+ *  @return zeroed submission entry
+ */
+static struct io_uring_sqe *uring_sqe(struct uring *ring, enum uring_op op, unsigned index)
+{
+    struct io_uring_sqe *sqe;
+    unsigned slot;
+
+    if (ring->sq_local_tail - load_acquire(ring->sq_head) >= ring->sq_entries) {
+        uring_submit(ring, 0);
+    }
+
+    slot = ring->sq_local_tail & *ring->sq_mask;
+    sqe = &ring->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = ((uint64_t)index << URING_OP_BITS) | op;
+
+    ring->sq_array[slot] = slot;
+    ring->sq_local_tail++;
+
+    return sqe;
+}
+
+
+/**
+ *  Accept connections directly into free fixed file slots, one request for many connections
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the listening socket
+ */
+static void uring_accept(struct uring *ring, struct worker *worker)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_ACCEPT, 0);
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = worker->sockfd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->file_index = IORING_FILE_INDEX_ALLOC;
+    ring->accept_armed = 1;
+}
+
+
+/**
+ *  Arm the accept again when a connection is waiting, after the accept failed with no connection to close
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the listening socket
+ */
+static void uring_listen(struct uring *ring, struct worker *worker)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_LISTEN, 0);
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = worker->sockfd;
+    sqe->poll32_events = POLLIN;
+    ring->accept_armed = 1;
+}
+
+
+/**
+ *  Accept one waiting connection through the spare descriptor and close it at once
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the listening socket
+ */
+static void uring_drop(struct uring *ring, struct worker *worker)
+{
+    int fd;
+
+    if (ring->spare_fd < 0) {
+        return;
+    }
+
+    close(ring->spare_fd);
+    fd = accept4(worker->sockfd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd >= 0) {
+        close(fd);
+        fprintf(stderr, "Error: Out of file descriptors, connection dropped\n");
+    }
+    ring->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+
+/**
+ *  Receive into the registered buffer of the connection
+ *  @param ring     io_uring instance
+ *  @param conn     connection
+ */
+static void uring_recv(struct uring *ring, struct connection *conn)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_RECV, conn->fd);
+
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = conn->fd;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = (uintptr_t)(conn->buffer + conn->length);
+    sqe->len = CONNECTION_BUFSIZE - conn->length;
+    sqe->buf_index = conn->fd;
+}
+
+
+/**
+ *  Send the unsent part of the response straight from the cache buffers
+ *  @param ring     io_uring instance
+ *  @param conn     connection
+ */
+static void uring_send(struct uring *ring, struct connection *conn)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_SEND, conn->fd);
+
+    memset(&conn->msg, 0, sizeof(conn->msg));
+    conn->msg.msg_iov = conn->iov + conn->iov_index;
+    conn->msg.msg_iovlen = conn->iovcnt;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->fd;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = (uintptr_t)&conn->msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+}
+
+
+/**
+ *  Close the connection and free its fixed file slot
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ */
+static void uring_close(struct uring *ring, struct worker *worker, struct connection *conn)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_CLOSE, conn->fd);
+
+    connection_end(worker, conn);
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = conn->fd + 1;
+}
+
+
+/**
+ *  Watch inotify events of the cache
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the cache
+ */
+static void uring_poll(struct uring *ring, struct worker *worker)
+{
+    struct io_uring_sqe *sqe = uring_sqe(ring, URING_POLL, 0);
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = worker->cache.inotify_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+}
+
+
+/**
+ *  Send the response if it is ready or receive more data
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the connection
+ *  @param conn     connection
+ */
+static void uring_serve(struct uring *ring, struct worker *worker, struct connection *conn)
+{
+    if (connection_process(worker, conn)) {
+        uring_send(ring, conn);
+    } else {
+        uring_recv(ring, conn);
+    }
+}
+
+
+/**
+ *  Handle one completion
+ *  @param ring     io_uring instance
+ *  @param worker   worker owning the connections
+ *  @param cqe      completion entry
+ */
+static void uring_complete(struct uring *ring, struct worker *worker, struct io_uring_cqe *cqe)
+{
+    enum uring_op op = cqe->user_data & URING_OP_MASK;
+    struct connection *conn = &ring->conns[cqe->user_data >> URING_OP_BITS];
+
+    switch (op) {
+        case URING_ACCEPT:
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                ring->accept_armed = 0;
+            }
+            if (cqe->res >= 0) {
+                conn = &ring->conns[cqe->res];
+                connection_init(worker, conn, cqe->res);
+                ring->connections++;
+                uring_recv(ring, conn);
+            }
+            if (ring->accept_armed) {
+                break;
+            }
+
+            // Accepting again at once would fail the same way, over and over.
+            // Out of fixed file slots or descriptors, a close makes room and accepts again.
+            // With nothing to close, the waiting connection is dropped and the next one waited for
+            if (cqe->res == -ENFILE || cqe->res == -EMFILE) {
+                if (ring->connections == 0) {
+                    uring_drop(ring, worker);
+                    uring_listen(ring, worker);
+                }
+            } else {
+                uring_accept(ring, worker);
+            }
+            break;
+
+        case URING_RECV:
+            if (cqe->res <= 0) {
+                uring_close(ring, worker, conn);
+                break;
+            }
+            connection_received(worker, conn, cqe->res);
+            uring_serve(ring, worker, conn);
+            break;
+
+        case URING_SEND:
+            if (cqe->res < 0) {
+                uring_close(ring, worker, conn);
+                break;
+            }
+            if (!connection_sent(worker, conn, cqe->res)) {
+                uring_send(ring, conn);
+            } else if (!connection_next(conn)) {
+                uring_close(ring, worker, conn);
+            } else {
+                uring_serve(ring, worker, conn);
+            }
+            break;
+
+        case URING_CLOSE:
+            ring->connections--;
+            if (!ring->accept_armed) {
+                uring_accept(ring, worker);
+            }
+            break;
+
+        case URING_LISTEN:
+            uring_accept(ring, worker);
+            break;
+
+        case URING_POLL:
+            cache_process_events(&worker->cache);
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                uring_poll(ring, worker);
+            }
+            break;
+    }
+}
+
+
+/**
+ *  Create the rings and register connection buffers and the fixed file table
+ *  @param ring     io_uring instance
+ *  @return 0 on success or -1 if io_uring is unavailable
+ */
+static int uring_init(struct uring *ring)
+{
+    struct io_uring_params params;
+    struct io_uring_rsrc_register files;
+    struct iovec *buffers;
+    unsigned i;
+    int status;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = URING_CONNECTIONS * 2;
+
+    ring->spare_fd = -1;
+    ring->sq_ring = MAP_FAILED;
+    ring->sqes = MAP_FAILED;
+
+    ring->fd = uring_setup(URING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        goto fail;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        goto fail;
+    }
+    ring->cq_ring = ring->sq_ring;
+
+    ring->sq_head = (unsigned *)((char *)ring->sq_ring + params.sq_off.head);
+    ring->sq_tail = (unsigned *)((char *)ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)((char *)ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((char *)ring->sq_ring + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+
+    ring->cq_head = (unsigned *)((char *)ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *)((char *)ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)((char *)ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((char *)ring->cq_ring + params.cq_off.cqes);
+
+    // Accepted sockets go straight into the fixed file table, no descriptor lookups per I/O
+    memset(&files, 0, sizeof(files));
+    files.nr = URING_CONNECTIONS;
+    files.flags = IORING_RSRC_REGISTER_SPARSE;
+
+    if (uring_register(ring->fd, IORING_REGISTER_FILES2, &files, sizeof(files)) < 0) {
+        goto fail;
+    }
+
+    // Receive buffers are pinned once instead of on every read
+    ring->conns = calloc(URING_CONNECTIONS, sizeof(struct connection));
+    buffers = calloc(URING_CONNECTIONS, sizeof(struct iovec));
+    if (!ring->conns || !buffers) {
+        fprintf(stderr, "Error: Allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < URING_CONNECTIONS; i++) {
+        buffers[i].iov_base = ring->conns[i].buffer;
+        buffers[i].iov_len = CONNECTION_BUFSIZE;
+    }
+
+    status = uring_register(ring->fd, IORING_REGISTER_BUFFERS, buffers, URING_CONNECTIONS);
+    free(buffers);
+
+    if (status < 0) {
+        goto fail;
+    }
+
+    ring->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return 0;
+
+fail:
+    free(ring->conns);
+    if (ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->sq_ring != MAP_FAILED) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    close(ring->fd);
+    return -1;
+}
+
+
+/**
+ *  Serve connections with batched asynchronous I/O
+ *  @param worker   worker to run
+ *  @return -1 if io_uring is unavailable, otherwise does not return
+ */
+int uring_loop(struct worker *worker)
+{
+    struct uring ring;
+    unsigned head, tail;
+
+    if (uring_init(&ring) < 0) {
+        return -1;
+    }
+    worker_started(worker, BACKEND_URING);
+
+    uring_accept(&ring, worker);
+    if (worker->cache.inotify_fd >= 0) {
+        uring_poll(&ring, worker);
+    }
+
+    while (1) {
+        // One system call submits everything queued by the previous batch and waits for more
+        uring_submit(&ring, 1);
+
+        head = *ring.cq_head;
+        tail = load_acquire(ring.cq_tail);
+
+        while (head != tail) {
+            uring_complete(&ring, worker, &ring.cqes[head & *ring.cq_mask]);
+            head++;
+
+            // Completions of the entries submitted while handling this batch
+            if (head == tail) {
+                store_release(ring.cq_head, head);
+                tail = load_acquire(ring.cq_tail);
+            }
+        }
+
+        store_release(ring.cq_head, head);
+    }
+
+    return 0;
+}